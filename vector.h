@@ -28,22 +28,354 @@
 #define __VECTOR_H__
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 /* For the documentation on VECTOR_DECLARE and VECTOR_DEFINE,
  * jump to the bottom of this file.
  */
 
 #define _VECTOR_MAX(x, y) ((x) > (y) ? (x) : (y))
 
+/* The file scope helpers below are inline where the compiler supports it,
+ * so this file still builds as C89.
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define _VECTOR_INLINE inline
+#elif defined(__GNUC__)
+#define _VECTOR_INLINE __inline__
+#else
+#define _VECTOR_INLINE
+#endif
+
+/* Sorted vector operations switch from a linear merge to galloping when one
+ * input is this many times longer than the other.
+ */
+#define _VECTOR_GALLOP_RATIO 16
+#define _VECTOR_SKEWED(small, large) ((small) * _VECTOR_GALLOP_RATIO < (large))
+
+/* Depth of the run stack of _stable_sort(), enough for 2^64 elements */
+#define _VECTOR_MAX_RUNS 85
+
+/* Number of elements _gather() and _scatter() prefetch ahead. Define it
+ * before including this file to tune it, or to 0 to disable prefetching.
+ */
+#ifndef VECTOR_PREFETCH_DISTANCE
+#define VECTOR_PREFETCH_DISTANCE 16
+#endif
+
+#if defined(__GNUC__)
+#define _VECTOR_PREFETCH(p, rw) __builtin_prefetch(p, rw)
+#else
+#define _VECTOR_PREFETCH(p, rw) ((void)(p))
+#endif
+
+/* Copies elements 'i' up to 'n' of 'src' to the end of 'dst' and sets 'i'
+ * to 'n'. 'dst' must have enough capacity. Empty ranges are skipped, as
+ * either array may then be NULL.
+ */
+#define _VECTOR_COPY_RANGE(dst, src, i, n) \
+	do { \
+		if ((n) > (i)) { \
+			memcpy(&(dst)->arr[(dst)->len], &(src)->arr[i], \
+				((n) - (i)) * sizeof(*(src)->arr)); \
+			(dst)->len += (n) - (i); \
+			(i) = (n); \
+		} \
+	} while (0)
+
+/* Returns the number of set bits in 'x'. */
+static _VECTOR_INLINE unsigned
+_vector_popcount(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(x);
+#else
+	x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+	x = (x & UINT64_C(0x3333333333333333)) +
+		((x >> 2) & UINT64_C(0x3333333333333333));
+	x = (x + (x >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+	return (x * UINT64_C(0x0101010101010101)) >> 56;
+#endif
+}
+
+/* Returns the index of the lowest set bit in 'x', which must not be 0. */
+static _VECTOR_INLINE unsigned
+_vector_ctz(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(x);
+#else
+	unsigned n = 0;
+
+	while (!(x & 1)) {
+		n++;
+		x >>= 1;
+	}
+
+	return n;
+#endif
+}
+
+/* Returns the index of the set bit of rank 'k' in 'x', which must have more
+ * than 'k' bits set.
+ */
+static _VECTOR_INLINE unsigned
+_vector_select64(uint64_t x, unsigned k)
+{
+#if defined(__BMI2__)
+	return _vector_ctz(_pdep_u64(UINT64_C(1) << k, x));
+#else
+	while (k--)
+		x &= x - 1;
+
+	return _vector_ctz(x);
+#endif
+}
+
+/* Control bytes of a hash index slot. Full slots hold the low 7 bits of
+ * the hash, so the high bit marks a free slot.
+ */
+#define _VECTOR_SLOT_EMPTY 0x80
+#define _VECTOR_SLOT_DELETED 0xfe
+
+/* Returns the largest number of entries a hash index of 'cap' slots holds */
+#define _VECTOR_INDEX_MAX_LOAD(cap) ((cap) - (cap) / 8)
+
+/* Mixes a user supplied hash so both the low 7 bits and the slot bits
+ * depend on every input bit.
+ */
+static _VECTOR_INLINE uint64_t
+_vector_hash_mix(size_t h)
+{
+	uint64_t m = (uint64_t)h * UINT64_C(0x9e3779b97f4a7c15);
+
+	return m ^ (m >> 32);
+}
+
+/* Group Match
+ *
+ * Returns a mask of the slots in the 16 control bytes at 'ctrl' equal to
+ * 'c', lowest slot first.
+ */
+static _VECTOR_INLINE unsigned
+_vector_group_match(const unsigned char *ctrl, unsigned char c)
+{
+#if defined(__SSE2__)
+	__m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)c)));
+#else
+	unsigned i, m = 0;
+
+	for (i = 0; i < 16; i++)
+		m |= (unsigned)(ctrl[i] == c) << i;
+
+	return m;
+#endif
+}
+
+/* Returns a mask of the empty or deleted slots in the 16 control bytes at
+ * 'ctrl', lowest slot first.
+ */
+static _VECTOR_INLINE unsigned
+_vector_group_free(const unsigned char *ctrl)
+{
+#if defined(__SSE2__)
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+	unsigned i, m = 0;
+
+	for (i = 0; i < 16; i++)
+		m |= (unsigned)(ctrl[i] >> 7) << i;
+
+	return m;
+#endif
+}
+
+/* Sets control byte 'i' of a hash index with 'cap' slots. The first 16
+ * bytes are mirrored past the end so groups can be loaded across the
+ * wrap around.
+ */
+static _VECTOR_INLINE void
+_vector_set_ctrl(unsigned char *ctrl, size_t cap, size_t i, unsigned char c)
+{
+	ctrl[i] = c;
+	if (i < 16)
+		ctrl[cap + i] = c;
+}
+
+/* Returns the first free slot on the probe sequence of hash 'm' */
+static _VECTOR_INLINE size_t
+_vector_free_slot(const unsigned char *ctrl, size_t cap, uint64_t m)
+{
+	size_t p = (m >> 7) & (cap - 1), step = 0;
+	unsigned free;
+
+	while (!(free = _vector_group_free(&ctrl[p]))) {
+		step += 16;
+		p = (p + step) & (cap - 1);
+	}
+
+	return (p + _vector_ctz(free)) & (cap - 1);
+}
+
+/* Number of elements in each block of a frozen vector. The bit packing
+ * below depends on this being 128.
+ */
+#define _VECTOR_BLOCK_LEN 128
+
+/* Block
+ *
+ * Header of one block of a frozen vector. 'off' is the index of the first
+ * word of the block and 'bits' is the width of each packed value, 64 meaning
+ * the values are stored unpacked. When 'delta' is set, element 0 equals
+ * 'base' and element i equals element i - 1 plus 'step' plus packed value i.
+ * Otherwise element i equals 'base' plus packed value i.
+ */
+struct _vector_block {
+	uint64_t base, step;
+	size_t off;
+	unsigned char bits, delta;
+};
+
+/* Returns the number of bits needed to represent 'x'. */
+static _VECTOR_INLINE unsigned
+_vector_bit_width(uint64_t x)
+{
+	unsigned n = 0;
+
+	while (x) {
+		n++;
+		x >>= 1;
+	}
+
+	return n;
+}
+
+/* Returns the number of 32 bit words used by a block of 'bits' width. */
+static _VECTOR_INLINE size_t
+_vector_block_words(unsigned bits)
+{
+	return bits == 64 ? 2 * _VECTOR_BLOCK_LEN : 4 * bits;
+}
+
+/* Bit Pack
+ *
+ * Packs 128 values of at most 'bits' (0 to 32) bits each into 4 * 'bits'
+ * words. The words are interleaved across 4 lanes with value i stored in
+ * lane i % 4, so a single SSE2 register decodes 4 consecutive values.
+ */
+static _VECTOR_INLINE void
+_vector_bp_pack(uint32_t *w, const uint32_t *in, unsigned bits)
+{
+	size_t i;
+
+	if (!bits)
+		return;
+
+	memset(w, 0, 4 * bits * sizeof(uint32_t));
+
+	for (i = 0; i < _VECTOR_BLOCK_LEN; i++) {
+		size_t lane = i & 3, pos = (i >> 2) * bits, word = pos >> 5;
+		unsigned sh = pos & 31;
+
+		w[word * 4 + lane] |= in[i] << sh;
+		if (sh + bits > 32)
+			w[(word + 1) * 4 + lane] |= in[i] >> (32 - sh);
+	}
+}
+
+/* Bit Get
+ *
+ * Returns value 'i' from a block packed by _vector_bp_pack().
+ */
+static _VECTOR_INLINE uint32_t
+_vector_bp_get(const uint32_t *w, unsigned bits, size_t i)
+{
+	size_t lane = i & 3, pos = (i >> 2) * bits, word = pos >> 5;
+	unsigned sh = pos & 31;
+	uint32_t x;
+
+	if (!bits)
+		return 0;
+
+	x = w[word * 4 + lane] >> sh;
+	if (sh + bits > 32)
+		x |= w[(word + 1) * 4 + lane] << (32 - sh);
+
+	return bits < 32 ? x & ((UINT32_C(1) << bits) - 1) : x;
+}
+
+/* Bit Unpack
+ *
+ * Unpacks all 128 values of a block packed by _vector_bp_pack() into 'out'.
+ */
+static _VECTOR_INLINE void
+_vector_bp_unpack(const uint32_t *w, unsigned bits, uint32_t *out)
+{
+#if defined(__SSE2__)
+	__m128i mask, x;
+	size_t k;
+
+	if (!bits) {
+		memset(out, 0, _VECTOR_BLOCK_LEN * sizeof(uint32_t));
+		return;
+	}
+
+	mask = _mm_set1_epi32(bits < 32 ? (int)((UINT32_C(1) << bits) - 1) : -1);
+	for (k = 0; k < _VECTOR_BLOCK_LEN / 4; k++) {
+		size_t pos = k * bits, word = pos >> 5;
+		unsigned sh = pos & 31;
+
+		x = _mm_loadu_si128((const __m128i *)&w[word * 4]);
+		x = _mm_srl_epi32(x, _mm_cvtsi32_si128(sh));
+		if (sh + bits > 32)
+			x = _mm_or_si128(x, _mm_sll_epi32(
+				_mm_loadu_si128((const __m128i *)&w[(word + 1) * 4]),
+				_mm_cvtsi32_si128(32 - sh)));
+		_mm_storeu_si128((__m128i *)&out[k * 4], _mm_and_si128(x, mask));
+	}
+#else
+	size_t i;
+
+	for (i = 0; i < _VECTOR_BLOCK_LEN; i++)
+		out[i] = _vector_bp_get(w, bits, i);
+#endif
+}
+
 /* Type
  *
- * Defines the vector struct containing the fields len, cap, and arr. The
- * struct is typedefed to namespace_t.
+ * Defines the vector struct containing the fields len, cap, arr and index.
+ * The struct is typedefed to namespace_t. 'index' is the hash index
+ * attached by _index_build(), or NULL.
+ *
+ * The hash index has 'cap' slots. Slot i holds the position 'pos[i]' of an
+ * element when control byte 'ctrl[i]' is the low 7 bits of its hash.
+ * 'used' counts the full slots and 'dead' the deleted ones.
  */
-#define _VECTOR_DEFINE_TYPE(vect_t, base_t) \
-	typedef struct vect_t {size_t len, cap; base_t *arr; } vect_t;
+#define _VECTOR_DEFINE_TYPE(namespace, base_t, vect_t) \
+	typedef struct namespace ## _index_t { \
+		size_t cap, used, dead; \
+		unsigned char *ctrl; \
+		size_t *pos; \
+		size_t (*hash) (base_t); \
+		int (*eq) (base_t, base_t); \
+	} namespace ## _index_t; \
+	typedef struct vect_t { \
+		size_t len, cap; \
+		base_t *arr; \
+		namespace ## _index_t *index; \
+	} vect_t;
 
 /* Init
  *
@@ -59,6 +391,7 @@
 		v->len = 0; \
 		v->cap = 0; \
 		v->arr = NULL; \
+		v->index = NULL; \
 		return v; \
 	}
 
@@ -90,6 +423,7 @@
 #define _VECTOR_DEFINE_DESTROY(namespace, base_t, vect_t) \
 	_VECTOR_DECLARE_DESTROY(namespace, base_t, vect_t) \
 	{ \
+		namespace ## _index_drop (v); \
 		free(v->arr); \
 	}
 
@@ -149,8 +483,8 @@
  * Set the length of the vector to 'len'. If 'len' is greater than the current
  * capacity of the vector, the vector is automatically reallocated using
  * _expand(). If 'len' is greater than the current length, the new
- * elements are unitialized. Returns 0 on success, or -1 if on an allocation
- * failure.
+ * elements are unitialized and the hash index is dropped. Returns 0 on
+ * success, or -1 if on an allocation failure.
  */
 #define _VECTOR_DECLARE_SET_LEN(namespace, base_t, vect_t) \
 	int namespace ## _set_len (vect_t *v, size_t len)
@@ -160,6 +494,11 @@
 	{ \
 		if (len > v->cap && namespace ## _expand (v, len)) \
 			return -1; \
+	\
+		if (v->index && len > v->len) \
+			namespace ## _index_drop (v); \
+		while (v->index && v->len > len) \
+			_ ## namespace ## _index_del (v, --v->len); \
 	\
 		v->len = len; \
 		return 0; \
@@ -204,8 +543,12 @@
 	{ \
 		if (v->len == v->cap && namespace ## _expand (v, v->len + 1)) \
 			return -1; \
+		if (v->index && _ ## namespace ## _index_reserve (v, v->len + 1)) \
+			return -1; \
 	\
 		v->arr[v->len++] = x; \
+		if (v->index) \
+			_ ## namespace ## _index_add (v, v->len - 1); \
 		return 0; \
 	}
 
@@ -229,6 +572,8 @@
 		if (out) \
 			*out = v->arr[v->len - 1]; \
 	\
+		if (v->index) \
+			_ ## namespace ## _index_del (v, v->len - 1); \
 		v->len--; \
 		return 0; \
 	}
@@ -250,6 +595,15 @@
 			errno = ERANGE; \
 			return -1; \
 		} \
+	\
+		if (v->index && i != j) { \
+			size_t si = _ ## namespace ## _index_slot (v, i); \
+			size_t sj = _ ## namespace ## _index_slot (v, j); \
+			if (si != SIZE_MAX) \
+				v->index->pos[si] = j; \
+			if (sj != SIZE_MAX) \
+				v->index->pos[sj] = i; \
+		} \
 	\
 		tmp = v->arr[i]; \
 		v->arr[i] = v->arr[j]; \
@@ -295,7 +649,11 @@
 			return -1; \
 		} \
 	\
+		if (v->index) \
+			_ ## namespace ## _index_del (v, i); \
 		v->arr[i] = x; \
+		if (v->index) \
+			_ ## namespace ## _index_add (v, i); \
 		return 0; \
 	}
 
@@ -318,18 +676,24 @@
 			return -1; \
 		} \
 	\
-		if (namespace ## _set_len (v, _VECTOR_MAX(v->len, i) + 1)) \
+		if (v->len == v->cap && namespace ## _expand (v, v->len + 1)) \
+			return -1; \
+		if (v->index && _ ## namespace ## _index_reserve (v, v->len + 1)) \
 			return -1; \
 	\
-		v->arr[v->len - 1] = v->arr[i]; \
+		if (v->index && i < v->len) \
+			_ ## namespace ## _index_move (v, i, v->len); \
+		v->arr[v->len++] = v->arr[i]; \
 		v->arr[i] = x; \
+		if (v->index) \
+			_ ## namespace ## _index_add (v, i); \
 		return 0; \
 	}
 
 /* Insert
  *
  * Behaves the same as _insert_fast(), but shifts all elements up
- * one position to preserve order.
+ * one position to preserve order. The hash index is rebuilt.
  */
 #define _VECTOR_DECLARE_INSERT(namespace, base_t, vect_t) \
 	int namespace ## _insert (vect_t *v, size_t i, base_t x)
@@ -342,11 +706,16 @@
 			return -1; \
 		} \
 	\
-		if (namespace ## _set_len (v, _VECTOR_MAX(v->len, i) + 1)) \
+		if (v->len == v->cap && namespace ## _expand (v, v->len + 1)) \
+			return -1; \
+		if (v->index && _ ## namespace ## _index_reserve (v, v->len + 1)) \
 			return -1; \
 	\
+		v->len++; \
 		memmove(&v->arr[i + 1], &v->arr[i], (v->len - 1 - i) * sizeof(base_t)); \
 		v->arr[i] = x; \
+		if (v->index) \
+			_ ## namespace ## _index_rehash (v); \
 		return 0; \
 	}
 
@@ -369,6 +738,12 @@
 	\
 		if (out) \
 			*out = v->arr[i]; \
+	\
+		if (v->index) { \
+			_ ## namespace ## _index_del (v, i); \
+			if (i != v->len - 1) \
+				_ ## namespace ## _index_move (v, v->len - 1, i); \
+		} \
 	\
 		v->arr[i] = v->arr[v->len - 1]; \
 		v->len--; \
@@ -378,7 +753,7 @@
 /* Remove
  *
  * Behaves the same as _remove_fast(), but shifts all elements in the
- * vector down one position to preserve order.
+ * vector down one position to preserve order. The hash index is rebuilt.
  */
 #define _VECTOR_DECLARE_REMOVE(namespace, base_t, vect_t) \
 	int namespace ## _remove (vect_t *v, size_t i, base_t *out)
@@ -396,6 +771,8 @@
 	\
 		memmove(&v->arr[i], &v->arr[i + 1], (v->len - i) * sizeof(base_t)); \
 		v->len--; \
+		if (v->index) \
+			_ ## namespace ## _index_rehash (v); \
 		return 0; \
 	}
 
@@ -404,7 +781,7 @@
  * Takes a vector and a comparison function and sorts the list using
  * quicksort. The comparison function should return -1 if the first element is
  * less than the second argument, 1 if the first element is larger, and 0 if
- * they are equal.
+ * they are equal. The hash index is rebuilt once the vector is sorted.
  */
 #define _VECTOR_DECLARE_QUICKSORT(namespace, base_t, vect_t) \
 	void namespace ## _quicksort (vect_t *v, int (*compare) (base_t, base_t))
@@ -415,6 +792,15 @@
 		base_t piv; \
 		size_t lo, hi; \
 		vect_t v1, v2; \
+		namespace ## _index_t *index = v->index; \
+	\
+		if (index) { \
+			v->index = NULL; \
+			namespace ## _quicksort (v, compare); \
+			v->index = index; \
+			_ ## namespace ## _index_rehash (v); \
+			return; \
+		} \
 	\
 		if (v->len < 2) \
 			return; \
@@ -429,98 +815,1995 @@
 		} \
 		v1.len = lo; \
 		v1.arr = v->arr; \
+		v1.index = NULL; \
 		v2.len = v->len - v1.len; \
 		v2.arr = v->arr + v1.len; \
+		v2.index = NULL; \
 	\
 		namespace ## _quicksort(&v1, compare); \
 		namespace ## _quicksort(&v2, compare); \
 		return; \
 	}
 
-/*
- * Do Declare
+/* Stable Sort
+ *
+ * Sorts the vector like _quicksort(), but keeps equal elements in their
+ * original order. Existing ascending and strictly descending runs are
+ * detected and merged, so nearly sorted vectors are sorted in close to
+ * linear time. 'scratch' is used as temporary storage: it is expanded to
+ * half the length of 'v' if needed, its elements are overwritten, its hash
+ * index is dropped and it keeps its capacity, so reusing it for later sorts
+ * avoids allocating. The hash index of 'v' is rebuilt once the vector is
+ * sorted. Returns 0 on success or -1 on an allocation failure, in which
+ * case 'v' is not changed.
  */
-#define _VECTOR_DO_DECLARE(how, namespace, base_t, vect_t) \
-	_VECTOR_DEFINE_TYPE(vect_t, base_t) \
-	how _VECTOR_DECLARE_INIT(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_ALLOC(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_DESTROY(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_FREE(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_EXPAND(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_SET_LEN(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_LEN(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_CAP(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_PUSH(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_POP(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_SWAP(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_INDEX(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_SET_INDEX(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_INSERT_FAST(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_INSERT(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_REMOVE_FAST(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_REMOVE(namespace, base_t, vect_t); \
-	how _VECTOR_DECLARE_QUICKSORT(namespace, base_t, vect_t);
+#define _VECTOR_DECLARE_STABLE_SORT(namespace, base_t, vect_t) \
+	int namespace ## _stable_sort (vect_t *v, vect_t *scratch, \
+		int (*compare) (base_t, base_t))
 
-/*
- * Do Define
+#define _VECTOR_DEFINE_STABLE_SORT(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_STABLE_SORT(namespace, base_t, vect_t) \
+	{ \
+		size_t run_lo[_VECTOR_MAX_RUNS], run_len[_VECTOR_MAX_RUNS]; \
+		size_t n = v->len, min_run, lo = 0, h = 0, i, j, k, r = 0; \
+		base_t *a = v->arr, *s, x; \
+	\
+		namespace ## _index_drop (scratch); \
+		if (n < 2) \
+			return 0; \
+		if (namespace ## _expand (scratch, n / 2 + 1)) \
+			return -1; \
+		s = scratch->arr; \
+	\
+		/* Runs shorter than min_run, between 32 and 64, are extended */ \
+		for (min_run = n; min_run >= 64; min_run >>= 1) \
+			r |= min_run & 1; \
+		min_run += r; \
+	\
+		do { \
+			/* Find the next run, reversing it if strictly descending */ \
+			i = lo + 1; \
+			if (i < n && compare(a[i], a[lo]) < 0) { \
+				while (++i < n && compare(a[i], a[i - 1]) < 0) \
+					; \
+				for (j = lo, k = i - 1; j < k; j++, k--) { \
+					x = a[j]; \
+					a[j] = a[k]; \
+					a[k] = x; \
+				} \
+			} else { \
+				while (i < n && compare(a[i], a[i - 1]) >= 0) \
+					i++; \
+			} \
+	\
+			/* Extend a short run with binary insertion */ \
+			for (k = lo + min_run < n ? lo + min_run : n; i < k; i++) { \
+				size_t l = lo, u = i, m; \
+	\
+				x = a[i]; \
+				while (l < u) { \
+					m = l + (u - l) / 2; \
+					if (compare(x, a[m]) < 0) \
+						u = m; \
+					else \
+						l = m + 1; \
+				} \
+				memmove(&a[l + 1], &a[l], (i - l) * sizeof(base_t)); \
+				a[l] = x; \
+			} \
+	\
+			run_lo[h] = lo; \
+			run_len[h++] = i - lo; \
+			lo = i; \
+	\
+			/* Merge runs until the stack invariants hold, or all of \
+			 * them once the vector has been scanned. \
+			 */ \
+			while (h > 1) { \
+				size_t l, mid, u, m; \
+	\
+				k = h - 2; \
+				if (lo < n) { \
+					if ((k > 0 && run_len[k - 1] <= run_len[k] + run_len[k + 1]) || \
+						(k > 1 && run_len[k - 2] <= run_len[k - 1] + run_len[k])) { \
+						if (run_len[k - 1] < run_len[k + 1]) \
+							k--; \
+					} else if (run_len[k] > run_len[k + 1]) { \
+						break; \
+					} \
+				} else if (k > 0 && run_len[k - 1] < run_len[k + 1]) { \
+					k--; \
+				} \
+	\
+				l = run_lo[k]; \
+				mid = l + run_len[k]; \
+				u = mid + run_len[k + 1]; \
+				run_len[k] += run_len[k + 1]; \
+				if (k + 3 == h) { \
+					run_lo[k + 1] = run_lo[k + 2]; \
+					run_len[k + 1] = run_len[k + 2]; \
+				} \
+				h--; \
+	\
+				/* Elements of the left run not above the first of the \
+				 * right run, and elements of the right run not below the \
+				 * last of the left run, are already in place. \
+				 */ \
+				for (j = mid; l < j;) { \
+					m = l + (j - l) / 2; \
+					if (compare(a[mid], a[m]) < 0) \
+						j = m; \
+					else \
+						l = m + 1; \
+				} \
+				for (j = mid; j < u;) { \
+					m = j + (u - j) / 2; \
+					if (compare(a[m], a[mid - 1]) < 0) \
+						j = m + 1; \
+					else \
+						u = m; \
+				} \
+				if (l == mid || mid == u) \
+					continue; \
+	\
+				if (mid - l <= u - mid) { \
+					/* Merge forwards with the left run in scratch */ \
+					memcpy(s, &a[l], (mid - l) * sizeof(base_t)); \
+					for (i = 0, j = mid, m = mid - l; i < m && j < u;) \
+						a[l++] = compare(a[j], s[i]) < 0 ? a[j++] : s[i++]; \
+					memcpy(&a[l], &s[i], (m - i) * sizeof(base_t)); \
+				} else { \
+					/* Merge backwards with the right run in scratch */ \
+					memcpy(s, &a[mid], (u - mid) * sizeof(base_t)); \
+					for (i = mid, j = u - mid; i > l && j > 0;) \
+						a[--u] = compare(s[j - 1], a[i - 1]) < 0 ? \
+							a[--i] : s[--j]; \
+					memcpy(&a[l], s, j * sizeof(base_t)); \
+				} \
+			} \
+		} while (lo < n); \
+	\
+		if (v->index) \
+			_ ## namespace ## _index_rehash (v); \
+		return 0; \
+	}
+
+/* Gallop
+ *
+ * Returns the index of the first element at or after index 'i' that is not
+ * less than 'x', or the length of the vector if there is none. The vector
+ * must be sorted. The search steps forward exponentially from 'i', so it
+ * is fast when the result is close to 'i'.
  */
-#define _VECTOR_DO_DEFINE(how, namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_INIT(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_ALLOC(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_DESTROY(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_FREE(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_EXPAND(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_SET_LEN(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_LEN(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_CAP(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_PUSH(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_POP(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_SWAP(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_INDEX(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_SET_INDEX(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_INSERT_FAST(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_INSERT(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_REMOVE_FAST(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_REMOVE(namespace, base_t, vect_t) \
-	how _VECTOR_DEFINE_QUICKSORT(namespace, base_t, vect_t)
+#define _VECTOR_DECLARE_GALLOP(namespace, base_t, vect_t) \
+	size_t namespace ## _gallop (vect_t *v, size_t i, base_t x, \
+		int (*compare) (base_t, base_t))
 
-/* Declare
+#define _VECTOR_DEFINE_GALLOP(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_GALLOP(namespace, base_t, vect_t) \
+	{ \
+		size_t lo = i, hi = i, step = 1, mid; \
+	\
+		while (hi < v->len && compare(v->arr[hi], x) < 0) { \
+			lo = hi + 1; \
+			hi += step; \
+			step *= 2; \
+		} \
+		if (hi > v->len) \
+			hi = v->len; \
+	\
+		while (lo < hi) { \
+			mid = lo + (hi - lo) / 2; \
+			if (compare(v->arr[mid], x) < 0) \
+				lo = mid + 1; \
+			else \
+				hi = mid; \
+		} \
+		return lo; \
+	}
+
+/* Merge
  *
- * Defines the vector struct and declares all of the associated functions.
+ * Merges the sorted vectors 'a' and 'b' into 'out', replacing its contents
+ * and dropping its hash index. Equal elements are taken from 'a' first.
+ * 'out' must not be 'a' or 'b'.
+ * The comparison function is the same as the one used by _quicksort().
+ * Returns 0 on success or -1 on an allocation failure.
+ */
+#define _VECTOR_DECLARE_MERGE(namespace, base_t, vect_t) \
+	int namespace ## _merge (vect_t *a, vect_t *b, vect_t *out, \
+		int (*compare) (base_t, base_t))
+
+#define _VECTOR_DEFINE_MERGE(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_MERGE(namespace, base_t, vect_t) \
+	{ \
+		size_t i = 0, j = 0, n; \
+	\
+		if (namespace ## _expand (out, a->len + b->len)) \
+			return -1; \
+	\
+		namespace ## _index_drop (out); \
+		out->len = 0; \
+		if (_VECTOR_SKEWED(b->len, a->len)) { \
+			for (; j < b->len; j++) { \
+				n = namespace ## _gallop (a, i, b->arr[j], compare); \
+				while (n < a->len && !compare(a->arr[n], b->arr[j])) \
+					n++; \
+				_VECTOR_COPY_RANGE(out, a, i, n); \
+				out->arr[out->len++] = b->arr[j]; \
+			} \
+		} else if (_VECTOR_SKEWED(a->len, b->len)) { \
+			for (; i < a->len; i++) { \
+				n = namespace ## _gallop (b, j, a->arr[i], compare); \
+				_VECTOR_COPY_RANGE(out, b, j, n); \
+				out->arr[out->len++] = a->arr[i]; \
+			} \
+		} else { \
+			while (i < a->len && j < b->len) \
+				out->arr[out->len++] = compare(b->arr[j], a->arr[i]) < 0 ? \
+					b->arr[j++] : a->arr[i++]; \
+		} \
+	\
+		_VECTOR_COPY_RANGE(out, a, i, a->len); \
+		_VECTOR_COPY_RANGE(out, b, j, b->len); \
+		return 0; \
+	}
+
+/* Merge Many
  *
- * The 'how' field is a list of keywords to place in front of the function
- * declarations such as 'static inline', 'static', or 'extern'. In C99 and C11,
- * this field can be left blank, but C89 does not allow this behavior and you
- * will need to place 'extern' in this field.
+ * Merges the 'n' sorted vectors in 'vs' into 'out' using a heap, replacing
+ * its contents and dropping its hash index. Equal elements are taken from
+ * the earlier vector first. 'out' must not be one of the inputs. Returns 0
+ * on success or -1 on an allocation failure.
+ */
+#define _VECTOR_DECLARE_MERGE_MANY(namespace, base_t, vect_t) \
+	int namespace ## _merge_many (vect_t **vs, size_t n, vect_t *out, \
+		int (*compare) (base_t, base_t))
+
+#define _VECTOR_DEFINE_MERGE_MANY(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_MERGE_MANY(namespace, base_t, vect_t) \
+	{ \
+		size_t *pos, *heap, h = 0, i, j, k, total = 0; \
+	\
+		for (k = 0; k < n; k++) \
+			total += vs[k]->len; \
+		if (namespace ## _expand (out, total)) \
+			return -1; \
+	\
+		namespace ## _index_drop (out); \
+		out->len = 0; \
+		if (!n) \
+			return 0; \
+	\
+		pos = malloc(2 * n * sizeof(size_t)); \
+		if (!pos) \
+			return -1; \
+	\
+		heap = pos + n; \
+		for (k = 0; k < n; k++) { \
+			pos[k] = 0; \
+			if (vs[k]->len) \
+				heap[h++] = k; \
+		} \
+	\
+		/* Heapify the nodes below h / 2, then pop the smallest cursor */ \
+		for (j = h / 2;;) { \
+			if (j) { \
+				i = --j; \
+			} else { \
+				if (!h) \
+					break; \
+				k = heap[0]; \
+				out->arr[out->len++] = vs[k]->arr[pos[k]++]; \
+				if (pos[k] == vs[k]->len) \
+					heap[0] = heap[--h]; \
+				i = 0; \
+			} \
+	\
+			for (;;) { \
+				size_t c = 2 * i + 1, x, y; \
+				int cmp; \
+	\
+				if (c >= h) \
+					break; \
+				if (c + 1 < h) { \
+					x = heap[c + 1]; \
+					y = heap[c]; \
+					cmp = compare(vs[x]->arr[pos[x]], vs[y]->arr[pos[y]]); \
+					if (cmp < 0 || (!cmp && x < y)) \
+						c++; \
+				} \
+				x = heap[c]; \
+				y = heap[i]; \
+				cmp = compare(vs[x]->arr[pos[x]], vs[y]->arr[pos[y]]); \
+				if (cmp > 0 || (!cmp && x > y)) \
+					break; \
+				heap[c] = y; \
+				heap[i] = x; \
+				i = c; \
+			} \
+		} \
+	\
+		free(pos); \
+		return 0; \
+	}
+
+/* Set Union
  *
- * The 'namespace' argument allows you to customize the names of the type and
- * the functions. The defined type will always be 'namespace_t' and the
- * functions will be of the format 'namespace_method'.
+ * Stores the elements found in either of the sorted vectors 'a' and 'b' in
+ * 'out', replacing its contents. Elements found in both are stored once,
+ * taken from 'a'. Like _merge(), 'out' must not be an input and loses its
+ * hash index, galloping is used when the lengths are skewed, and -1 is
+ * returned on an allocation failure.
+ */
+#define _VECTOR_DECLARE_SET_UNION(namespace, base_t, vect_t) \
+	int namespace ## _set_union (vect_t *a, vect_t *b, vect_t *out, \
+		int (*compare) (base_t, base_t))
+
+#define _VECTOR_DEFINE_SET_UNION(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_SET_UNION(namespace, base_t, vect_t) \
+	{ \
+		size_t i = 0, j = 0, n; \
+		int cmp; \
+	\
+		if (namespace ## _expand (out, a->len + b->len)) \
+			return -1; \
+	\
+		namespace ## _index_drop (out); \
+		out->len = 0; \
+		if (_VECTOR_SKEWED(b->len, a->len)) { \
+			for (; j < b->len; j++) { \
+				n = namespace ## _gallop (a, i, b->arr[j], compare); \
+				_VECTOR_COPY_RANGE(out, a, i, n); \
+				if (i < a->len && !compare(a->arr[i], b->arr[j])) \
+					out->arr[out->len++] = a->arr[i++]; \
+				else \
+					out->arr[out->len++] = b->arr[j]; \
+			} \
+		} else if (_VECTOR_SKEWED(a->len, b->len)) { \
+			for (; i < a->len; i++) { \
+				n = namespace ## _gallop (b, j, a->arr[i], compare); \
+				_VECTOR_COPY_RANGE(out, b, j, n); \
+				out->arr[out->len++] = a->arr[i]; \
+				if (j < b->len && !compare(b->arr[j], a->arr[i])) \
+					j++; \
+			} \
+		} else { \
+			while (i < a->len && j < b->len) { \
+				cmp = compare(a->arr[i], b->arr[j]); \
+				if (cmp > 0) { \
+					out->arr[out->len++] = b->arr[j++]; \
+					continue; \
+				} \
+				if (!cmp) \
+					j++; \
+				out->arr[out->len++] = a->arr[i++]; \
+			} \
+		} \
+	\
+		_VECTOR_COPY_RANGE(out, a, i, a->len); \
+		_VECTOR_COPY_RANGE(out, b, j, b->len); \
+		return 0; \
+	}
+
+/* Set Intersection
  *
- * The 'type' field is the underlying type of the vector.
+ * Stores the elements of the sorted vector 'a' that are also found in the
+ * sorted vector 'b' in 'out', replacing its contents. Like _merge(), 'out'
+ * must not be an input and loses its hash index, galloping is used when
+ * the lengths are skewed, and -1 is returned on an allocation failure.
  */
-#define VECTOR_DECLARE(how, namespace, type) \
-	_VECTOR_DO_DECLARE(how, namespace, type, namespace ## _t)
+#define _VECTOR_DECLARE_SET_INTERSECTION(namespace, base_t, vect_t) \
+	int namespace ## _set_intersection (vect_t *a, vect_t *b, vect_t *out, \
+		int (*compare) (base_t, base_t))
 
-/* Define
+#define _VECTOR_DEFINE_SET_INTERSECTION(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_SET_INTERSECTION(namespace, base_t, vect_t) \
+	{ \
+		size_t i = 0, j = 0; \
+		int cmp; \
+	\
+		if (namespace ## _expand (out, a->len < b->len ? a->len : b->len)) \
+			return -1; \
+	\
+		namespace ## _index_drop (out); \
+		out->len = 0; \
+		if (_VECTOR_SKEWED(a->len, b->len)) { \
+			for (; i < a->len; i++) { \
+				j = namespace ## _gallop (b, j, a->arr[i], compare); \
+				if (j == b->len) \
+					break; \
+				if (!compare(b->arr[j], a->arr[i])) { \
+					out->arr[out->len++] = a->arr[i]; \
+					j++; \
+				} \
+			} \
+		} else if (_VECTOR_SKEWED(b->len, a->len)) { \
+			for (; j < b->len; j++) { \
+				i = namespace ## _gallop (a, i, b->arr[j], compare); \
+				if (i == a->len) \
+					break; \
+				if (!compare(a->arr[i], b->arr[j])) \
+					out->arr[out->len++] = a->arr[i++]; \
+			} \
+		} else { \
+			while (i < a->len && j < b->len) { \
+				cmp = compare(a->arr[i], b->arr[j]); \
+				if (cmp < 0) { \
+					i++; \
+				} else if (cmp > 0) { \
+					j++; \
+				} else { \
+					out->arr[out->len++] = a->arr[i++]; \
+					j++; \
+				} \
+			} \
+		} \
+	\
+		return 0; \
+	}
+
+/* Set Difference
  *
- * Defines the functions declared by VECTOR_DECLARE. The arguments to this macro
- * are the same as the ones in VECTOR_DECLARE.
+ * Stores the elements of the sorted vector 'a' that are not found in the
+ * sorted vector 'b' in 'out', replacing its contents. Like _merge(), 'out'
+ * must not be an input and loses its hash index, galloping is used when
+ * the lengths are skewed, and -1 is returned on an allocation failure.
  */
-#define VECTOR_DEFINE(how, namespace, type) \
-	_VECTOR_DO_DEFINE(how, namespace, type, namespace ## _t)
+#define _VECTOR_DECLARE_SET_DIFFERENCE(namespace, base_t, vect_t) \
+	int namespace ## _set_difference (vect_t *a, vect_t *b, vect_t *out, \
+		int (*compare) (base_t, base_t))
 
-/* Declare and Define
+#define _VECTOR_DEFINE_SET_DIFFERENCE(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_SET_DIFFERENCE(namespace, base_t, vect_t) \
+	{ \
+		size_t i = 0, j = 0, n; \
+		int cmp; \
+	\
+		if (namespace ## _expand (out, a->len)) \
+			return -1; \
+	\
+		namespace ## _index_drop (out); \
+		out->len = 0; \
+		if (_VECTOR_SKEWED(a->len, b->len)) { \
+			for (; i < a->len; i++) { \
+				j = namespace ## _gallop (b, j, a->arr[i], compare); \
+				if (j < b->len && !compare(b->arr[j], a->arr[i])) \
+					j++; \
+				else \
+					out->arr[out->len++] = a->arr[i]; \
+			} \
+		} else if (_VECTOR_SKEWED(b->len, a->len)) { \
+			for (; j < b->len; j++) { \
+				n = namespace ## _gallop (a, i, b->arr[j], compare); \
+				_VECTOR_COPY_RANGE(out, a, i, n); \
+				if (i < a->len && !compare(a->arr[i], b->arr[j])) \
+					i++; \
+			} \
+		} else { \
+			while (i < a->len && j < b->len) { \
+				cmp = compare(a->arr[i], b->arr[j]); \
+				if (cmp < 0) { \
+					out->arr[out->len++] = a->arr[i++]; \
+				} else { \
+					if (!cmp) \
+						i++; \
+					j++; \
+				} \
+			} \
+		} \
+	\
+		_VECTOR_COPY_RANGE(out, a, i, a->len); \
+		return 0; \
+	}
+
+/* Gather
  *
- * A shortcut which calls VECTOR_DECLARE and VECTOR_DEFINE.
+ * Stores the elements at the 'n' positions in 'indices' in 'out', so
+ * out[k] is index indices[k] of the vector. The bounds are checked for the
+ * whole batch rather than per element: if any index is outside the range of
+ * the vector, -1 is returned and the contents of 'out' are unspecified, but
+ * no element outside the vector is read. Elements are prefetched
+ * VECTOR_PREFETCH_DISTANCE positions ahead. With AVX2, vectors of 64 bit
+ * elements are read with gather instructions.
  */
-#define VECTOR_DECLARE_AND_DEFINE(how, namespace, type) \
-	VECTOR_DECLARE(how, namespace, type) \
-	VECTOR_DEFINE(how, namespace, type)
+#define _VECTOR_DECLARE_GATHER(namespace, base_t, vect_t) \
+	int namespace ## _gather (vect_t *v, const size_t *indices, size_t n, \
+		base_t *out)
 
-/*
- * Initialize a statically allocated vector.
+#define _VECTOR_DEFINE_GATHER(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_GATHER(namespace, base_t, vect_t) \
+	{ \
+		size_t i = 0, k; \
+		int bad = 0; \
+	\
+		if (n && !v->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		_VECTOR_GATHER_AVX2(base_t, v, indices, n, out, i, bad) \
+		/* Out of range indices read element 0 and fail the batch */ \
+		for (; i < n; i++) { \
+			if (VECTOR_PREFETCH_DISTANCE > 0 && \
+				n - i > VECTOR_PREFETCH_DISTANCE) { \
+				k = indices[i + VECTOR_PREFETCH_DISTANCE]; \
+				_VECTOR_PREFETCH(v->arr + (k < v->len ? k : 0), 0); \
+			} \
+			k = indices[i]; \
+			bad |= k >= v->len; \
+			out[i] = v->arr[k < v->len ? k : 0]; \
+		} \
+	\
+		if (bad) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		return 0; \
+	}
+
+#if defined(__AVX2__)
+/* Lanes with an index outside the vector are masked off the gather, and
+ * prefetch element 0 instead. The comparison is signed, so the sign bits
+ * are flipped first.
+ */
+#define _VECTOR_GATHER_AVX2(base_t, v, indices, n, out, i, bad) \
+	if (sizeof(base_t) == 8 && sizeof(size_t) == 8) { \
+		const __m256i sign = _mm256_set1_epi64x(INT64_MIN); \
+		const __m256i len = _mm256_xor_si256(sign, \
+			_mm256_set1_epi64x((long long)v->len)); \
+		__m256i idx, mask, fail = _mm256_setzero_si256(); \
+		size_t l; \
+	\
+		for (; i < n / 4 * 4; i += 4) { \
+			if (VECTOR_PREFETCH_DISTANCE > 0 && \
+				n - i >= 4 + VECTOR_PREFETCH_DISTANCE) \
+				for (l = 0; l < 4; l++) { \
+					k = indices[i + l + VECTOR_PREFETCH_DISTANCE]; \
+					_VECTOR_PREFETCH(v->arr + (k < v->len ? k : 0), 0); \
+				} \
+			idx = _mm256_loadu_si256((const __m256i *)&indices[i]); \
+			mask = _mm256_cmpgt_epi64(len, _mm256_xor_si256(idx, sign)); \
+			fail = _mm256_or_si256(fail, _mm256_xor_si256(mask, \
+				_mm256_set1_epi64x(-1))); \
+			_mm256_storeu_si256((__m256i *)&out[i], \
+				_mm256_mask_i64gather_epi64(_mm256_setzero_si256(), \
+					(const long long *)v->arr, idx, mask, 8)); \
+		} \
+		bad = !_mm256_testz_si256(fail, fail); \
+	}
+#else
+#define _VECTOR_GATHER_AVX2(base_t, v, indices, n, out, i, bad)
+#endif
+
+/* Scatter
+ *
+ * Sets index indices[k] of the vector to values[k] for each of the 'n'
+ * positions, in order, so the last value wins for repeated indices. All
+ * indices are checked before anything is written, and if any is outside
+ * the range of the vector, -1 is returned and the vector is not changed.
+ * Elements are prefetched VECTOR_PREFETCH_DISTANCE positions ahead, unless
+ * the vector has a hash index, which is updated one element at a time.
+ */
+#define _VECTOR_DECLARE_SCATTER(namespace, base_t, vect_t) \
+	int namespace ## _scatter (vect_t *v, const size_t *indices, \
+		const base_t *values, size_t n)
+
+#define _VECTOR_DEFINE_SCATTER(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_SCATTER(namespace, base_t, vect_t) \
+	{ \
+		size_t i, max = 0; \
+	\
+		for (i = 0; i < n; i++) \
+			max = _VECTOR_MAX(max, indices[i]); \
+		if (n && max >= v->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		if (v->index) { \
+			for (i = 0; i < n; i++) { \
+				_ ## namespace ## _index_del (v, indices[i]); \
+				v->arr[indices[i]] = values[i]; \
+				_ ## namespace ## _index_add (v, indices[i]); \
+			} \
+			return 0; \
+		} \
+	\
+		for (i = 0; VECTOR_PREFETCH_DISTANCE > 0 && \
+			i + VECTOR_PREFETCH_DISTANCE < n; i++) { \
+			_VECTOR_PREFETCH(&v->arr[indices[i + VECTOR_PREFETCH_DISTANCE]], 1); \
+			v->arr[indices[i]] = values[i]; \
+		} \
+		for (; i < n; i++) \
+			v->arr[indices[i]] = values[i]; \
+	\
+		return 0; \
+	}
+
+/* Index Build
+ *
+ * Attaches a hash index to the vector, replacing any existing one, so
+ * _index_find() can look up elements in constant time. 'hash' and 'eq'
+ * hash and compare elements, 'eq' returning non-zero when its arguments
+ * are equal. The index is kept up to date by _push(), _pop(), _swap(),
+ * _set_index(), _insert_fast(), _remove_fast() and _scatter(), and is
+ * rebuilt by _insert(), _remove(), _quicksort() and _stable_sort(). It is
+ * dropped when _set_len() grows the vector, the vector is the output of
+ * a merge or set operation, or it is the scratch vector of _stable_sort().
+ * Returns 0 on success or -1 on an allocation failure.
+ */
+#define _VECTOR_DECLARE_INDEX_BUILD(namespace, base_t, vect_t) \
+	int namespace ## _index_build (vect_t *v, size_t (*hash) (base_t), \
+		int (*eq) (base_t, base_t))
+
+#define _VECTOR_DEFINE_INDEX_BUILD(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_BUILD(namespace, base_t, vect_t) \
+	{ \
+		namespace ## _index_drop (v); \
+	\
+		v->index = malloc(sizeof(*v->index)); \
+		if (!v->index) \
+			return -1; \
+	\
+		v->index->cap = 0; \
+		v->index->ctrl = NULL; \
+		v->index->pos = NULL; \
+		v->index->hash = hash; \
+		v->index->eq = eq; \
+		if (_ ## namespace ## _index_reserve (v, v->len)) { \
+			namespace ## _index_drop (v); \
+			return -1; \
+		} \
+		return 0; \
+	}
+
+/* Index Drop
+ *
+ * Frees the hash index of the vector, if it has one.
+ */
+#define _VECTOR_DECLARE_INDEX_DROP(namespace, base_t, vect_t) \
+	void namespace ## _index_drop (vect_t *v)
+
+#define _VECTOR_DEFINE_INDEX_DROP(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_DROP(namespace, base_t, vect_t) \
+	{ \
+		if (!v->index) \
+			return; \
+	\
+		free(v->index->ctrl); \
+		free(v->index->pos); \
+		free(v->index); \
+		v->index = NULL; \
+	}
+
+/* Index Find
+ *
+ * Find an element equal to 'x' using the hash index and store its position
+ * in 'out'. Groups of 16 slots are probed at once with SSE2. If the vector
+ * holds several elements equal to 'x', any one of their positions is
+ * stored. Returns -1 with errno set to ENOENT if there is no such element,
+ * or EINVAL if the vector has no hash index, and 'out' is not set.
+ */
+#define _VECTOR_DECLARE_INDEX_FIND(namespace, base_t, vect_t) \
+	int namespace ## _index_find (vect_t *v, base_t x, size_t *out)
+
+#define _VECTOR_DEFINE_INDEX_FIND(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_FIND(namespace, base_t, vect_t) \
+	{ \
+		namespace ## _index_t *ix = v->index; \
+		uint64_t m; \
+		size_t p, step = 0; \
+		unsigned match; \
+	\
+		if (!ix) { \
+			errno = EINVAL; \
+			return -1; \
+		} \
+	\
+		m = _vector_hash_mix(ix->hash(x)); \
+		p = (m >> 7) & (ix->cap - 1); \
+		for (;;) { \
+			match = _vector_group_match(&ix->ctrl[p], m & 0x7f); \
+			while (match) { \
+				size_t i = (p + _vector_ctz(match)) & (ix->cap - 1); \
+				if (ix->eq(v->arr[ix->pos[i]], x)) { \
+					if (out) \
+						*out = ix->pos[i]; \
+					return 0; \
+				} \
+				match &= match - 1; \
+			} \
+			if (_vector_group_match(&ix->ctrl[p], _VECTOR_SLOT_EMPTY)) \
+				break; \
+			step += 16; \
+			p = (p + step) & (ix->cap - 1); \
+		} \
+	\
+		errno = ENOENT; \
+		return -1; \
+	}
+
+/* The index functions below are internal. They are generated with a leading
+ * underscore, as _namespace_index_reserve() and so on, and are called by the
+ * mutators to keep the hash index up to date.
+ */
+
+/* Index Reserve
+ *
+ * Grows the hash index, if needed, so it can hold 'n' elements without
+ * allocating. Returns 0 on success, or if the vector has no hash index, or
+ * -1 on an allocation failure, in which case the index is not changed.
+ */
+#define _VECTOR_DECLARE_INDEX_RESERVE(namespace, base_t, vect_t) \
+	int _ ## namespace ## _index_reserve (vect_t *v, size_t n)
+
+#define _VECTOR_DEFINE_INDEX_RESERVE(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_RESERVE(namespace, base_t, vect_t) \
+	{ \
+		namespace ## _index_t *ix = v->index; \
+		size_t cap, *pos; \
+		unsigned char *ctrl; \
+	\
+		if (!ix || (ix->cap && n <= _VECTOR_INDEX_MAX_LOAD(ix->cap))) \
+			return 0; \
+	\
+		cap = ix->cap ? ix->cap : 16; \
+		while (n > _VECTOR_INDEX_MAX_LOAD(cap)) \
+			cap *= 2; \
+		ctrl = malloc(cap + 16); \
+		pos = malloc(cap * sizeof(size_t)); \
+		if (!ctrl || !pos) { \
+			free(ctrl); \
+			free(pos); \
+			return -1; \
+		} \
+	\
+		free(ix->ctrl); \
+		free(ix->pos); \
+		ix->cap = cap; \
+		ix->ctrl = ctrl; \
+		ix->pos = pos; \
+		_ ## namespace ## _index_rehash (v); \
+		return 0; \
+	}
+
+/* Index Rehash
+ *
+ * Rebuilds the hash index from the elements of the vector, clearing
+ * deleted slots. If the vector no longer fits, the index is grown, or
+ * dropped when that fails.
+ */
+#define _VECTOR_DECLARE_INDEX_REHASH(namespace, base_t, vect_t) \
+	void _ ## namespace ## _index_rehash (vect_t *v)
+
+#define _VECTOR_DEFINE_INDEX_REHASH(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_REHASH(namespace, base_t, vect_t) \
+	{ \
+		namespace ## _index_t *ix = v->index; \
+		size_t i, slot; \
+		uint64_t m; \
+	\
+		if (!ix) \
+			return; \
+	\
+		if (!ix->cap || v->len > _VECTOR_INDEX_MAX_LOAD(ix->cap)) { \
+			if (_ ## namespace ## _index_reserve (v, v->len)) \
+				namespace ## _index_drop (v); \
+			return; \
+		} \
+	\
+		memset(ix->ctrl, _VECTOR_SLOT_EMPTY, ix->cap + 16); \
+		for (i = 0; i < v->len; i++) { \
+			m = _vector_hash_mix(ix->hash(v->arr[i])); \
+			slot = _vector_free_slot(ix->ctrl, ix->cap, m); \
+			_vector_set_ctrl(ix->ctrl, ix->cap, slot, m & 0x7f); \
+			ix->pos[slot] = i; \
+		} \
+		ix->used = v->len; \
+		ix->dead = 0; \
+	}
+
+/* Index Slot
+ *
+ * Returns the slot of the hash index holding position 'i', using the
+ * element stored there, or SIZE_MAX if the position is not in the index or
+ * the vector has no hash index.
+ */
+#define _VECTOR_DECLARE_INDEX_SLOT(namespace, base_t, vect_t) \
+	size_t _ ## namespace ## _index_slot (vect_t *v, size_t i)
+
+#define _VECTOR_DEFINE_INDEX_SLOT(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_SLOT(namespace, base_t, vect_t) \
+	{ \
+		namespace ## _index_t *ix = v->index; \
+		size_t p, step = 0, slot; \
+		uint64_t m; \
+		unsigned match; \
+	\
+		if (!ix || i >= v->cap) \
+			return SIZE_MAX; \
+	\
+		m = _vector_hash_mix(ix->hash(v->arr[i])); \
+		p = (m >> 7) & (ix->cap - 1); \
+		for (;;) { \
+			match = _vector_group_match(&ix->ctrl[p], m & 0x7f); \
+			while (match) { \
+				slot = (p + _vector_ctz(match)) & (ix->cap - 1); \
+				if (ix->pos[slot] == i) \
+					return slot; \
+				match &= match - 1; \
+			} \
+			if (_vector_group_match(&ix->ctrl[p], _VECTOR_SLOT_EMPTY)) \
+				return SIZE_MAX; \
+			step += 16; \
+			p = (p + step) & (ix->cap - 1); \
+		} \
+	}
+
+/* Index Add
+ *
+ * Adds position 'i' to the hash index, which must hold every other
+ * position of the vector. The index is rehashed instead when deleted slots
+ * fill it. Does nothing if the vector has no hash index.
+ */
+#define _VECTOR_DECLARE_INDEX_ADD(namespace, base_t, vect_t) \
+	void _ ## namespace ## _index_add (vect_t *v, size_t i)
+
+#define _VECTOR_DEFINE_INDEX_ADD(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_ADD(namespace, base_t, vect_t) \
+	{ \
+		namespace ## _index_t *ix = v->index; \
+		uint64_t m; \
+		size_t slot; \
+	\
+		if (!ix) \
+			return; \
+	\
+		if (ix->used + ix->dead >= _VECTOR_INDEX_MAX_LOAD(ix->cap)) { \
+			_ ## namespace ## _index_rehash (v); \
+			return; \
+		} \
+	\
+		m = _vector_hash_mix(ix->hash(v->arr[i])); \
+		slot = _vector_free_slot(ix->ctrl, ix->cap, m); \
+		if (ix->ctrl[slot] == _VECTOR_SLOT_DELETED) \
+			ix->dead--; \
+		_vector_set_ctrl(ix->ctrl, ix->cap, slot, m & 0x7f); \
+		ix->pos[slot] = i; \
+		ix->used++; \
+	}
+
+/* Index Del
+ *
+ * Removes position 'i' from the hash index, if it is there.
+ */
+#define _VECTOR_DECLARE_INDEX_DEL(namespace, base_t, vect_t) \
+	void _ ## namespace ## _index_del (vect_t *v, size_t i)
+
+#define _VECTOR_DEFINE_INDEX_DEL(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_DEL(namespace, base_t, vect_t) \
+	{ \
+		size_t slot = _ ## namespace ## _index_slot (v, i); \
+	\
+		if (slot == SIZE_MAX) \
+			return; \
+	\
+		_vector_set_ctrl(v->index->ctrl, v->index->cap, slot, \
+			_VECTOR_SLOT_DELETED); \
+		v->index->used--; \
+		v->index->dead++; \
+	}
+
+/* Index Move
+ *
+ * Changes position 'i' of the hash index to 'j', if it is there, while the
+ * element is still stored at 'i'.
+ */
+#define _VECTOR_DECLARE_INDEX_MOVE(namespace, base_t, vect_t) \
+	void _ ## namespace ## _index_move (vect_t *v, size_t i, size_t j)
+
+#define _VECTOR_DEFINE_INDEX_MOVE(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_INDEX_MOVE(namespace, base_t, vect_t) \
+	{ \
+		size_t slot = _ ## namespace ## _index_slot (v, i); \
+	\
+		if (slot != SIZE_MAX) \
+			v->index->pos[slot] = j; \
+	}
+
+/* Bits Type
+ *
+ * Defines the bit vector struct containing the fields len, cap, arr, n_rank
+ * and rank. 'len' and 'cap' are counted in bits and 'arr' holds the bits 64
+ * to a word, lowest bit first. Bits of the last word past 'len' are always
+ * 0. 'rank' is the rank directory built by _rank_build() and is only valid
+ * while 'n_rank' is not 0.
+ */
+#define _VECTOR_DEFINE_BITS_TYPE(vect_t) \
+	typedef struct vect_t { \
+		size_t len, cap; \
+		uint64_t *arr; \
+		size_t n_rank, *rank; \
+	} vect_t;
+
+/* Number of words counted by each entry of the rank directory */
+#define _VECTOR_RANK_WORDS 8
+
+/* Returns the number of words used by 'n' bits */
+#define _VECTOR_WORDS(n) (((n) + 63) / 64)
+
+/* Bits Init
+ *
+ * Initialize a statically allocated bit vector, returns the vector. This can
+ * also be achieved using the VECTOR_BITS_INITIALIZER macro.
+ */
+#define _VECTOR_DECLARE_BITS_INIT(namespace, vect_t) \
+	vect_t * namespace ## _init (vect_t *v)
+
+#define _VECTOR_DEFINE_BITS_INIT(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_INIT(namespace, vect_t) \
+	{ \
+		v->len = 0; \
+		v->cap = 0; \
+		v->arr = NULL; \
+		v->n_rank = 0; \
+		v->rank = NULL; \
+		return v; \
+	}
+
+/* Bits Destroy
+ *
+ * Destroy a statically allocated bit vector.
+ */
+#define _VECTOR_DECLARE_BITS_DESTROY(namespace, vect_t) \
+	void namespace ## _destroy (vect_t *v)
+
+#define _VECTOR_DEFINE_BITS_DESTROY(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_DESTROY(namespace, vect_t) \
+	{ \
+		free(v->arr); \
+		free(v->rank); \
+	}
+
+/* Bits Expand
+ *
+ * Expand the bit vector to 'new_cap' bits, which will be rounded up to the
+ * next power of 2 and at least 64. Returns 0 on success or -1 on an
+ * allocation failure.
+ */
+#define _VECTOR_DECLARE_BITS_EXPAND(namespace, vect_t) \
+	int namespace ## _expand (vect_t *v, size_t new_cap)
+
+#define _VECTOR_DEFINE_BITS_EXPAND(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_EXPAND(namespace, vect_t) \
+	{ \
+		uint64_t *tmp; \
+		/* Round new_cap up to the next power of 2 */ \
+		/* From https://graphics.stanford.edu/~seander/bithacks.html */ \
+		new_cap--; \
+		new_cap |= new_cap >> 1; \
+		new_cap |= new_cap >> 2; \
+		new_cap |= new_cap >> 4; \
+		new_cap |= new_cap >> 8; \
+		new_cap |= new_cap >> 16; \
+		new_cap++; \
+		new_cap = _VECTOR_MAX(new_cap, 64); \
+	\
+		if (new_cap <= v->cap) \
+			return 0; \
+	\
+		tmp = realloc(v->arr, _VECTOR_WORDS(new_cap) * sizeof(uint64_t)); \
+		if (!tmp) \
+			return -1; \
+	\
+		v->arr = tmp; \
+		v->cap = new_cap; \
+		return 0; \
+	}
+
+/* Bits Set Len
+ *
+ * Set the length of the bit vector to 'len' bits. Unlike _set_len() on
+ * other vectors, new bits are set to 0. Returns 0 on success, or -1 on an
+ * allocation failure.
+ */
+#define _VECTOR_DECLARE_BITS_SET_LEN(namespace, vect_t) \
+	int namespace ## _set_len (vect_t *v, size_t len)
+
+#define _VECTOR_DEFINE_BITS_SET_LEN(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_SET_LEN(namespace, vect_t) \
+	{ \
+		size_t old = _VECTOR_WORDS(v->len), new = _VECTOR_WORDS(len); \
+	\
+		if (len > v->cap && namespace ## _expand (v, len)) \
+			return -1; \
+	\
+		if (new > old) \
+			memset(&v->arr[old], 0, (new - old) * sizeof(uint64_t)); \
+		else if (len % 64) \
+			v->arr[new - 1] &= (UINT64_C(1) << len % 64) - 1; \
+	\
+		v->len = len; \
+		v->n_rank = 0; \
+		return 0; \
+	}
+
+/* Bits Push
+ *
+ * Pushes bit 'x' to the end of the bit vector, where any non-zero 'x' is a
+ * set bit. Returns 0 on success or -1 on an allocation failure.
+ */
+#define _VECTOR_DECLARE_BITS_PUSH(namespace, vect_t) \
+	int namespace ## _push (vect_t *v, int x)
+
+#define _VECTOR_DEFINE_BITS_PUSH(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_PUSH(namespace, vect_t) \
+	{ \
+		if (v->len == v->cap && namespace ## _expand (v, v->len + 1)) \
+			return -1; \
+	\
+		v->arr[v->len / 64] = (v->len % 64 ? v->arr[v->len / 64] : 0) | \
+			(uint64_t)(x != 0) << v->len % 64; \
+	\
+		v->len++; \
+		v->n_rank = 0; \
+		return 0; \
+	}
+
+/* Bits Pop
+ *
+ * Pop a bit off the end of the bit vector, storing it as 0 or 1 in 'out'.
+ * Out may be NULL. If the length of the vector is 0, -1 is returned and
+ * 'out' is not changed. Returns 0 on success.
+ */
+#define _VECTOR_DECLARE_BITS_POP(namespace, vect_t) \
+	int namespace ## _pop (vect_t *v, int *out)
+
+#define _VECTOR_DEFINE_BITS_POP(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_POP(namespace, vect_t) \
+	{ \
+		uint64_t mask; \
+	\
+		if (!v->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		v->len--; \
+		mask = UINT64_C(1) << v->len % 64; \
+		if (out) \
+			*out = (v->arr[v->len / 64] & mask) != 0; \
+	\
+		v->arr[v->len / 64] &= ~mask; \
+		v->n_rank = 0; \
+		return 0; \
+	}
+
+/* Bits Index
+ *
+ * Get bit 'i' from the bit vector and store it as 0 or 1 in 'out'. If 'i'
+ * is outside the range of the vector, -1 is returned and 'out' is not set.
+ */
+#define _VECTOR_DECLARE_BITS_INDEX(namespace, vect_t) \
+	int namespace ## _index (vect_t *v, size_t i, int *out)
+
+#define _VECTOR_DEFINE_BITS_INDEX(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_INDEX(namespace, vect_t) \
+	{ \
+		if (i >= v->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		if (out) \
+			*out = (v->arr[i / 64] >> i % 64) & 1; \
+	\
+		return 0; \
+	}
+
+/* Bits Set Index
+ *
+ * Set bit 'i' to 'x', where any non-zero 'x' is a set bit. If 'i' is
+ * outside the length of the vector, -1 is returned and the vector is not
+ * changed.
+ */
+#define _VECTOR_DECLARE_BITS_SET_INDEX(namespace, vect_t) \
+	int namespace ## _set_index (vect_t *v, size_t i, int x)
+
+#define _VECTOR_DEFINE_BITS_SET_INDEX(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_SET_INDEX(namespace, vect_t) \
+	{ \
+		if (i >= v->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		if (x) \
+			v->arr[i / 64] |= UINT64_C(1) << i % 64; \
+		else \
+			v->arr[i / 64] &= ~(UINT64_C(1) << i % 64); \
+	\
+		v->n_rank = 0; \
+		return 0; \
+	}
+
+/* Bits Bulk Operations
+ *
+ * _and(), _or(), _xor() and _andnot() replace 'v' with 'v & w', 'v | w',
+ * 'v ^ w' and 'v & ~w', a word at a time. If the vectors differ in length,
+ * -1 is returned and 'v' is not changed.
+ */
+#define _VECTOR_DECLARE_BITS_BULK(namespace, vect_t, name) \
+	int namespace ## _ ## name (vect_t *v, vect_t *w)
+
+#define _VECTOR_DEFINE_BITS_BULK(namespace, vect_t, name, op) \
+	_VECTOR_DECLARE_BITS_BULK(namespace, vect_t, name) \
+	{ \
+		size_t i, n = _VECTOR_WORDS(v->len); \
+	\
+		if (v->len != w->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		for (i = 0; i < n; i++) \
+			v->arr[i] = v->arr[i] op w->arr[i]; \
+	\
+		v->n_rank = 0; \
+		return 0; \
+	}
+
+/* Bits Count
+ *
+ * Returns the number of set bits in the bit vector.
+ */
+#define _VECTOR_DECLARE_BITS_COUNT(namespace, vect_t) \
+	size_t namespace ## _count (vect_t *v)
+
+#define _VECTOR_DEFINE_BITS_COUNT(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_COUNT(namespace, vect_t) \
+	{ \
+		size_t i, n = _VECTOR_WORDS(v->len), count = 0; \
+	\
+		for (i = 0; i < n; i++) \
+			count += _vector_popcount(v->arr[i]); \
+	\
+		return count; \
+	}
+
+/* Bits Find First Set
+ *
+ * Find the first set bit at or after index 'i' and store its index in
+ * 'out'. If there is no such bit, -1 is returned and 'out' is not set.
+ */
+#define _VECTOR_DECLARE_BITS_FIND_FIRST_SET(namespace, vect_t) \
+	int namespace ## _find_first_set (vect_t *v, size_t i, size_t *out)
+
+#define _VECTOR_DEFINE_BITS_FIND_FIRST_SET(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_FIND_FIRST_SET(namespace, vect_t) \
+	{ \
+		size_t n = _VECTOR_WORDS(v->len), k = i / 64; \
+		uint64_t x; \
+	\
+		if (i >= v->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		x = v->arr[k] & (~UINT64_C(0) << i % 64); \
+		while (!x) { \
+			if (++k == n) { \
+				errno = ERANGE; \
+				return -1; \
+			} \
+			x = v->arr[k]; \
+		} \
+	\
+		if (out) \
+			*out = k * 64 + _vector_ctz(x); \
+	\
+		return 0; \
+	}
+
+/* Bits Rank Build
+ *
+ * Builds the rank directory, which holds the number of set bits before
+ * every 512 bits and speeds up _rank() and _select(). Every function that
+ * modifies the vector discards the directory. Returns 0 on success or -1 on
+ * an allocation failure.
+ */
+#define _VECTOR_DECLARE_BITS_RANK_BUILD(namespace, vect_t) \
+	int namespace ## _rank_build (vect_t *v)
+
+#define _VECTOR_DEFINE_BITS_RANK_BUILD(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_RANK_BUILD(namespace, vect_t) \
+	{ \
+		size_t i, n = _VECTOR_WORDS(v->len), count = 0, *tmp; \
+		size_t n_rank = n / _VECTOR_RANK_WORDS + 1; \
+	\
+		tmp = realloc(v->rank, n_rank * sizeof(size_t)); \
+		if (!tmp) \
+			return -1; \
+	\
+		v->rank = tmp; \
+		for (i = 0; i < n; i++) { \
+			if (i % _VECTOR_RANK_WORDS == 0) \
+				v->rank[i / _VECTOR_RANK_WORDS] = count; \
+			count += _vector_popcount(v->arr[i]); \
+		} \
+		if (n % _VECTOR_RANK_WORDS == 0) \
+			v->rank[n_rank - 1] = count; \
+	\
+		v->n_rank = n_rank; \
+		return 0; \
+	}
+
+/* Bits Rank
+ *
+ * Returns the number of set bits before index 'i'. If 'i' is larger than
+ * the length of the vector, the number of set bits in the vector is
+ * returned.
+ */
+#define _VECTOR_DECLARE_BITS_RANK(namespace, vect_t) \
+	size_t namespace ## _rank (vect_t *v, size_t i)
+
+#define _VECTOR_DEFINE_BITS_RANK(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_RANK(namespace, vect_t) \
+	{ \
+		size_t k = 0, count = 0; \
+	\
+		if (i > v->len) \
+			i = v->len; \
+	\
+		if (v->n_rank) { \
+			k = i / 64 / _VECTOR_RANK_WORDS * _VECTOR_RANK_WORDS; \
+			count = v->rank[k / _VECTOR_RANK_WORDS]; \
+		} \
+	\
+		for (; k < i / 64; k++) \
+			count += _vector_popcount(v->arr[k]); \
+		if (i % 64) \
+			count += _vector_popcount(v->arr[k] & \
+				((UINT64_C(1) << i % 64) - 1)); \
+	\
+		return count; \
+	}
+
+/* Bits Select
+ *
+ * Find the index of the set bit with rank 'k', that is the set bit with 'k'
+ * set bits before it, and store it in 'out'. If the vector has 'k' or fewer
+ * set bits, -1 is returned and 'out' is not set.
+ */
+#define _VECTOR_DECLARE_BITS_SELECT(namespace, vect_t) \
+	int namespace ## _select (vect_t *v, size_t k, size_t *out)
+
+#define _VECTOR_DEFINE_BITS_SELECT(namespace, vect_t) \
+	_VECTOR_DECLARE_BITS_SELECT(namespace, vect_t) \
+	{ \
+		size_t i = 0, n = _VECTOR_WORDS(v->len), c; \
+	\
+		if (v->n_rank) { \
+			size_t lo = 0, hi = v->n_rank; \
+			/* Find the last directory entry not above 'k' */ \
+			while (hi - lo > 1) { \
+				size_t mid = lo + (hi - lo) / 2; \
+				if (v->rank[mid] <= k) \
+					lo = mid; \
+				else \
+					hi = mid; \
+			} \
+			i = lo * _VECTOR_RANK_WORDS; \
+			k -= v->rank[lo]; \
+		} \
+	\
+		for (; i < n; i++) { \
+			c = _vector_popcount(v->arr[i]); \
+			if (k < c) { \
+				if (out) \
+					*out = i * 64 + _vector_select64(v->arr[i], k); \
+				return 0; \
+			} \
+			k -= c; \
+		} \
+	\
+		errno = ERANGE; \
+		return -1; \
+	}
+
+/* Frozen Type
+ *
+ * Defines the read-only compressed vector namespace_frozen_t, containing the
+ * fields len, n_blocks, n_words, blocks and words, and its iterator
+ * namespace_frozen_iter_t.
+ */
+#define _VECTOR_DEFINE_FROZEN_TYPE(namespace, base_t) \
+	typedef struct namespace ## _frozen_t { \
+		size_t len, n_blocks, n_words; \
+		struct _vector_block *blocks; \
+		uint32_t *words; \
+	} namespace ## _frozen_t; \
+	typedef struct namespace ## _frozen_iter_t { \
+		namespace ## _frozen_t *f; \
+		size_t i; \
+		base_t buf[_VECTOR_BLOCK_LEN]; \
+	} namespace ## _frozen_iter_t;
+
+/* Freeze Compressed
+ *
+ * Compresses the vector into the read-only vector 'out'. The elements are
+ * split into blocks of 128 and every block is stored either as offsets from
+ * the block minimum or, when the block is sorted and it is smaller, as
+ * deltas between neighbouring elements. The offsets are bit-packed to the
+ * width of the largest one. 'v' is not modified. Returns 0 on success or -1
+ * on an allocation failure.
+ */
+#define _VECTOR_DECLARE_FREEZE_COMPRESSED(namespace, base_t, vect_t) \
+	int namespace ## _freeze_compressed (vect_t *v, \
+		namespace ## _frozen_t *out)
+
+#define _VECTOR_DEFINE_FREEZE_COMPRESSED(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_FREEZE_COMPRESSED(namespace, base_t, vect_t) \
+	{ \
+		struct _vector_block *b; \
+		uint32_t tmp[_VECTOR_BLOCK_LEN]; \
+		size_t i, j, n; \
+	\
+		out->len = v->len; \
+		out->n_blocks = (v->len + _VECTOR_BLOCK_LEN - 1) / _VECTOR_BLOCK_LEN; \
+		out->n_words = 0; \
+		out->blocks = NULL; \
+		out->words = NULL; \
+		if (!out->n_blocks) \
+			return 0; \
+	\
+		out->blocks = malloc(out->n_blocks * sizeof(*out->blocks)); \
+		if (!out->blocks) \
+			return -1; \
+	\
+		for (i = 0; i < out->n_blocks; i++) { \
+			base_t *x = &v->arr[i * _VECTOR_BLOCK_LEN]; \
+			base_t min = x[0], max = x[0]; \
+			uint64_t d, dmin = 0, dmax = 0; \
+			unsigned fbits, dbits; \
+			int sorted = 1; \
+	\
+			n = v->len - i * _VECTOR_BLOCK_LEN; \
+			if (n > _VECTOR_BLOCK_LEN) \
+				n = _VECTOR_BLOCK_LEN; \
+	\
+			for (j = 1; j < n; j++) { \
+				if (x[j] < min) \
+					min = x[j]; \
+				if (x[j] > max) \
+					max = x[j]; \
+				if (x[j] < x[j - 1]) { \
+					sorted = 0; \
+					continue; \
+				} \
+				d = (uint64_t)x[j] - (uint64_t)x[j - 1]; \
+				if (j == 1 || d < dmin) \
+					dmin = d; \
+				if (j == 1 || d > dmax) \
+					dmax = d; \
+			} \
+	\
+			b = &out->blocks[i]; \
+			b->off = out->n_words; \
+			fbits = _vector_bit_width((uint64_t)max - (uint64_t)min); \
+			dbits = sorted ? _vector_bit_width(dmax - dmin) : 64; \
+			if (dbits < fbits && dbits <= 32) { \
+				b->base = (uint64_t)x[0]; \
+				b->step = dmin; \
+				b->bits = dbits; \
+				b->delta = 1; \
+			} else { \
+				b->base = (uint64_t)min; \
+				b->step = 0; \
+				b->bits = fbits <= 32 ? fbits : 64; \
+				b->delta = 0; \
+			} \
+			out->n_words += _vector_block_words(b->bits); \
+		} \
+	\
+		if (out->n_words) { \
+			out->words = malloc(out->n_words * sizeof(uint32_t)); \
+			if (!out->words) { \
+				free(out->blocks); \
+				out->blocks = NULL; \
+				return -1; \
+			} \
+		} \
+	\
+		for (i = 0; i < out->n_blocks; i++) { \
+			base_t *x = &v->arr[i * _VECTOR_BLOCK_LEN]; \
+			uint32_t *w; \
+	\
+			/* Blocks of equal or evenly spaced values use no words */ \
+			b = &out->blocks[i]; \
+			if (!b->bits) \
+				continue; \
+	\
+			w = out->words + b->off; \
+			n = v->len - i * _VECTOR_BLOCK_LEN; \
+			if (n > _VECTOR_BLOCK_LEN) \
+				n = _VECTOR_BLOCK_LEN; \
+	\
+			if (b->bits == 64) { \
+				for (j = 0; j < n; j++) { \
+					uint64_t off = (uint64_t)x[j] - b->base; \
+					w[2 * j] = (uint32_t)off; \
+					w[2 * j + 1] = (uint32_t)(off >> 32); \
+				} \
+				memset(&w[2 * n], 0, \
+					2 * (_VECTOR_BLOCK_LEN - n) * sizeof(uint32_t)); \
+				continue; \
+			} \
+	\
+			tmp[0] = b->delta ? 0 : (uint32_t)((uint64_t)x[0] - b->base); \
+			for (j = 1; j < n; j++) \
+				tmp[j] = b->delta ? \
+					(uint32_t)((uint64_t)x[j] - (uint64_t)x[j - 1] - b->step) : \
+					(uint32_t)((uint64_t)x[j] - b->base); \
+			for (; j < _VECTOR_BLOCK_LEN; j++) \
+				tmp[j] = 0; \
+			_vector_bp_pack(w, tmp, b->bits); \
+		} \
+	\
+		return 0; \
+	}
+
+/* Frozen Destroy
+ *
+ * Destroy a frozen vector created by _freeze_compressed().
+ */
+#define _VECTOR_DECLARE_FROZEN_DESTROY(namespace, base_t, vect_t) \
+	void namespace ## _frozen_destroy (namespace ## _frozen_t *f)
+
+#define _VECTOR_DEFINE_FROZEN_DESTROY(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_FROZEN_DESTROY(namespace, base_t, vect_t) \
+	{ \
+		free(f->blocks); \
+		free(f->words); \
+	}
+
+/* Frozen Len
+ *
+ * Returns the length of the frozen vector.
+ */
+#define _VECTOR_DECLARE_FROZEN_LEN(namespace, base_t, vect_t) \
+	size_t namespace ## _frozen_len (namespace ## _frozen_t *f)
+
+#define _VECTOR_DEFINE_FROZEN_LEN(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_FROZEN_LEN(namespace, base_t, vect_t) \
+	{ \
+		return f->len; \
+	}
+
+/* Frozen Size
+ *
+ * Returns the number of bytes used by the frozen vector, including the
+ * block headers.
+ */
+#define _VECTOR_DECLARE_FROZEN_SIZE(namespace, base_t, vect_t) \
+	size_t namespace ## _frozen_size (namespace ## _frozen_t *f)
+
+#define _VECTOR_DEFINE_FROZEN_SIZE(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_FROZEN_SIZE(namespace, base_t, vect_t) \
+	{ \
+		return sizeof(*f) + f->n_blocks * sizeof(*f->blocks) + \
+			f->n_words * sizeof(*f->words); \
+	}
+
+/* Frozen Index
+ *
+ * Get index 'i' from the frozen vector and store it in 'out'. The block is
+ * found through its header, so only the elements before 'i' in a delta
+ * block are decoded. If 'i' is outside the range of the vector, -1 is
+ * returned and 'out' is not set.
+ */
+#define _VECTOR_DECLARE_FROZEN_INDEX(namespace, base_t, vect_t) \
+	int namespace ## _frozen_index (namespace ## _frozen_t *f, size_t i, \
+		base_t *out)
+
+#define _VECTOR_DEFINE_FROZEN_INDEX(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_FROZEN_INDEX(namespace, base_t, vect_t) \
+	{ \
+		struct _vector_block *b; \
+		uint32_t *w; \
+		uint64_t x; \
+		size_t j, k; \
+	\
+		if (i >= f->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		b = &f->blocks[i / _VECTOR_BLOCK_LEN]; \
+		w = b->bits ? f->words + b->off : NULL; \
+		j = i % _VECTOR_BLOCK_LEN; \
+	\
+		if (b->bits == 64) { \
+			x = b->base + (w[2 * j] | (uint64_t)w[2 * j + 1] << 32); \
+		} else if (!b->delta) { \
+			x = b->base + _vector_bp_get(w, b->bits, j); \
+		} else { \
+			x = b->base + j * b->step; \
+			for (k = 1; k <= j; k++) \
+				x += _vector_bp_get(w, b->bits, k); \
+		} \
+	\
+		if (out) \
+			*out = (base_t)x; \
+	\
+		return 0; \
+	}
+
+/* Frozen Decode
+ *
+ * Decodes block 'i' of the frozen vector into 'out', which must have room
+ * for 128 elements. Returns the number of elements in the block, or 0 if
+ * 'i' is not a block of the vector.
+ */
+#define _VECTOR_DECLARE_FROZEN_DECODE(namespace, base_t, vect_t) \
+	size_t namespace ## _frozen_decode (namespace ## _frozen_t *f, size_t i, \
+		base_t *out)
+
+#define _VECTOR_DEFINE_FROZEN_DECODE(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_FROZEN_DECODE(namespace, base_t, vect_t) \
+	{ \
+		struct _vector_block *b; \
+		uint32_t tmp[_VECTOR_BLOCK_LEN], *w; \
+		uint64_t x; \
+		size_t j, n; \
+	\
+		if (i >= f->n_blocks) \
+			return 0; \
+	\
+		b = &f->blocks[i]; \
+		w = b->bits ? f->words + b->off : NULL; \
+		n = f->len - i * _VECTOR_BLOCK_LEN; \
+		if (n > _VECTOR_BLOCK_LEN) \
+			n = _VECTOR_BLOCK_LEN; \
+	\
+		if (b->bits == 64) { \
+			for (j = 0; j < n; j++) \
+				out[j] = (base_t)(b->base + \
+					(w[2 * j] | (uint64_t)w[2 * j + 1] << 32)); \
+			return n; \
+		} \
+	\
+		_vector_bp_unpack(w, b->bits, tmp); \
+		if (!b->delta) { \
+			for (j = 0; j < n; j++) \
+				out[j] = (base_t)(b->base + tmp[j]); \
+			return n; \
+		} \
+	\
+		x = b->base; \
+		out[0] = (base_t)x; \
+		for (j = 1; j < n; j++) { \
+			x += b->step + tmp[j]; \
+			out[j] = (base_t)x; \
+		} \
+		return n; \
+	}
+
+/* Frozen Iter Init
+ *
+ * Initialize an iterator over the frozen vector 'f', returns the iterator.
+ */
+#define _VECTOR_DECLARE_FROZEN_ITER_INIT(namespace, base_t, vect_t) \
+	namespace ## _frozen_iter_t * namespace ## _frozen_iter_init ( \
+		namespace ## _frozen_iter_t *it, namespace ## _frozen_t *f)
+
+#define _VECTOR_DEFINE_FROZEN_ITER_INIT(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_FROZEN_ITER_INIT(namespace, base_t, vect_t) \
+	{ \
+		it->f = f; \
+		it->i = 0; \
+		return it; \
+	}
+
+/* Frozen Iter Next
+ *
+ * Store the next element of the frozen vector in 'out', decoding a whole
+ * block at a time. Out may be NULL. If the iterator is exhausted, -1 is
+ * returned and 'out' is not changed. Returns 0 on success.
+ */
+#define _VECTOR_DECLARE_FROZEN_ITER_NEXT(namespace, base_t, vect_t) \
+	int namespace ## _frozen_iter_next (namespace ## _frozen_iter_t *it, \
+		base_t *out)
+
+#define _VECTOR_DEFINE_FROZEN_ITER_NEXT(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_FROZEN_ITER_NEXT(namespace, base_t, vect_t) \
+	{ \
+		if (it->i >= it->f->len) { \
+			errno = ERANGE; \
+			return -1; \
+		} \
+	\
+		if (it->i % _VECTOR_BLOCK_LEN == 0) \
+			namespace ## _frozen_decode (it->f, \
+				it->i / _VECTOR_BLOCK_LEN, it->buf); \
+	\
+		if (out) \
+			*out = it->buf[it->i % _VECTOR_BLOCK_LEN]; \
+	\
+		it->i++; \
+		return 0; \
+	}
+
+/* Compare
+ *
+ * Compares 'x' and 'y' in their natural order, in the form expected by
+ * _quicksort() and the sorted vector functions.
+ */
+#define _VECTOR_DECLARE_COMPARE(namespace, base_t, vect_t) \
+	int namespace ## _compare (base_t x, base_t y)
+
+#define _VECTOR_DEFINE_COMPARE(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_COMPARE(namespace, base_t, vect_t) \
+	{ \
+		return (x > y) - (x < y); \
+	}
+
+/* Set Intersection Fast
+ *
+ * Behaves the same as _set_intersection() with _compare(), but requires
+ * both vectors to be strictly increasing. With SSE2, vectors of 32 and 64
+ * bit integers are compared 4 elements against 4 at a time.
+ */
+#define _VECTOR_DECLARE_SET_INTERSECTION_FAST(namespace, base_t, vect_t) \
+	int namespace ## _set_intersection_fast (vect_t *a, vect_t *b, \
+		vect_t *out)
+
+#if defined(__SSE2__)
+/* Returns a 4 bit mask of the elements of a[0..3] found in b[0..3] */
+#define _VECTOR_MATCH4(a, b, size) \
+	((size) == 4 ? _vector_match4_32(a, b) : _vector_match4_64(a, b))
+
+static _VECTOR_INLINE unsigned
+_vector_match4_32(const void *a, const void *b)
+{
+	__m128i x = _mm_loadu_si128((const __m128i *)a);
+	__m128i y = _mm_loadu_si128((const __m128i *)b);
+	__m128i m;
+
+	m = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi32(x, y),
+			_mm_cmpeq_epi32(x, _mm_shuffle_epi32(y, 0x39))),
+		_mm_or_si128(_mm_cmpeq_epi32(x, _mm_shuffle_epi32(y, 0x4e)),
+			_mm_cmpeq_epi32(x, _mm_shuffle_epi32(y, 0x93))));
+	return _mm_movemask_ps(_mm_castsi128_ps(m));
+}
+
+/* 64 bit lanes are equal when both of their 32 bit halves are */
+static _VECTOR_INLINE __m128i
+_vector_cmpeq64(__m128i x, __m128i y)
+{
+	__m128i m = _mm_cmpeq_epi32(x, y);
+
+	return _mm_and_si128(m, _mm_shuffle_epi32(m, 0xb1));
+}
+
+static _VECTOR_INLINE unsigned
+_vector_match4_64(const void *a, const void *b)
+{
+	const __m128i *pa = a, *pb = b;
+	__m128i x0 = _mm_loadu_si128(pa), x1 = _mm_loadu_si128(pa + 1);
+	__m128i y0 = _mm_loadu_si128(pb), y1 = _mm_loadu_si128(pb + 1);
+	__m128i s0 = _mm_shuffle_epi32(y0, 0x4e), s1 = _mm_shuffle_epi32(y1, 0x4e);
+	__m128i m0, m1;
+
+	m0 = _mm_or_si128(
+		_mm_or_si128(_vector_cmpeq64(x0, y0), _vector_cmpeq64(x0, s0)),
+		_mm_or_si128(_vector_cmpeq64(x0, y1), _vector_cmpeq64(x0, s1)));
+	m1 = _mm_or_si128(
+		_mm_or_si128(_vector_cmpeq64(x1, y0), _vector_cmpeq64(x1, s0)),
+		_mm_or_si128(_vector_cmpeq64(x1, y1), _vector_cmpeq64(x1, s1)));
+	return _mm_movemask_pd(_mm_castsi128_pd(m0)) |
+		_mm_movemask_pd(_mm_castsi128_pd(m1)) << 2;
+}
+
+/* Matches blocks of 4 elements, advancing the block with the smaller last
+ * element, or both blocks when their last elements are equal.
+ */
+#define _VECTOR_SET_INTERSECTION_BLOCKS(base_t, a, b, out, i, j) \
+	if (sizeof(base_t) == 4 || sizeof(base_t) == 8) { \
+		while (i + 4 <= a->len && j + 4 <= b->len) { \
+			unsigned m = _VECTOR_MATCH4(&a->arr[i], &b->arr[j], \
+				sizeof(base_t)); \
+			base_t amax = a->arr[i + 3], bmax = b->arr[j + 3]; \
+	\
+			while (m) { \
+				out->arr[out->len++] = a->arr[i + _vector_ctz(m)]; \
+				m &= m - 1; \
+			} \
+			if (amax <= bmax) \
+				i += 4; \
+			if (bmax <= amax) \
+				j += 4; \
+		} \
+	}
+#else
+#define _VECTOR_SET_INTERSECTION_BLOCKS(base_t, a, b, out, i, j)
+#endif
+
+#define _VECTOR_DEFINE_SET_INTERSECTION_FAST(namespace, base_t, vect_t) \
+	_VECTOR_DECLARE_SET_INTERSECTION_FAST(namespace, base_t, vect_t) \
+	{ \
+		size_t i = 0, j = 0; \
+	\
+		if (_VECTOR_SKEWED(a->len, b->len) || \
+			_VECTOR_SKEWED(b->len, a->len)) \
+			return namespace ## _set_intersection (a, b, out, \
+				namespace ## _compare); \
+	\
+		if (namespace ## _expand (out, a->len < b->len ? a->len : b->len)) \
+			return -1; \
+	\
+		namespace ## _index_drop (out); \
+		out->len = 0; \
+		_VECTOR_SET_INTERSECTION_BLOCKS(base_t, a, b, out, i, j) \
+		while (i < a->len && j < b->len) { \
+			if (a->arr[i] < b->arr[j]) { \
+				i++; \
+			} else if (a->arr[i] > b->arr[j]) { \
+				j++; \
+			} else { \
+				out->arr[out->len++] = a->arr[i++]; \
+				j++; \
+			} \
+		} \
+	\
+		return 0; \
+	}
+
+/*
+ * Do Declare
+ */
+#define _VECTOR_DO_DECLARE(how, namespace, base_t, vect_t) \
+	_VECTOR_DEFINE_TYPE(namespace, base_t, vect_t) \
+	how _VECTOR_DECLARE_INIT(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_ALLOC(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_DESTROY(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_FREE(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_EXPAND(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_SET_LEN(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_LEN(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_CAP(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_PUSH(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_POP(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_SWAP(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_SET_INDEX(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INSERT_FAST(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INSERT(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_REMOVE_FAST(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_REMOVE(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_QUICKSORT(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_STABLE_SORT(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_GALLOP(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_MERGE(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_MERGE_MANY(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_SET_UNION(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_SET_INTERSECTION(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_SET_DIFFERENCE(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_GATHER(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_SCATTER(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_BUILD(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_DROP(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_FIND(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_RESERVE(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_REHASH(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_SLOT(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_ADD(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_DEL(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_INDEX_MOVE(namespace, base_t, vect_t);
+
+/*
+ * Do Define
+ */
+#define _VECTOR_DO_DEFINE(how, namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INIT(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_ALLOC(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_DESTROY(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FREE(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_EXPAND(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_SET_LEN(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_LEN(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_CAP(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_PUSH(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_POP(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_SWAP(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_SET_INDEX(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INSERT_FAST(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INSERT(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_REMOVE_FAST(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_REMOVE(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_QUICKSORT(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_STABLE_SORT(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_GALLOP(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_MERGE(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_MERGE_MANY(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_SET_UNION(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_SET_INTERSECTION(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_SET_DIFFERENCE(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_GATHER(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_SCATTER(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_BUILD(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_DROP(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_FIND(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_RESERVE(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_REHASH(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_SLOT(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_ADD(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_DEL(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_INDEX_MOVE(namespace, base_t, vect_t)
+
+/*
+ * Do Declare Integer
+ */
+#define _VECTOR_DO_DECLARE_INTEGER(how, namespace, base_t, vect_t) \
+	_VECTOR_DEFINE_FROZEN_TYPE(namespace, base_t) \
+	how _VECTOR_DECLARE_FREEZE_COMPRESSED(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_FROZEN_DESTROY(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_FROZEN_LEN(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_FROZEN_SIZE(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_FROZEN_INDEX(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_FROZEN_DECODE(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_FROZEN_ITER_INIT(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_FROZEN_ITER_NEXT(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_COMPARE(namespace, base_t, vect_t); \
+	how _VECTOR_DECLARE_SET_INTERSECTION_FAST(namespace, base_t, vect_t);
+
+/*
+ * Do Define Integer
+ */
+#define _VECTOR_DO_DEFINE_INTEGER(how, namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FREEZE_COMPRESSED(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FROZEN_DESTROY(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FROZEN_LEN(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FROZEN_SIZE(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FROZEN_INDEX(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FROZEN_DECODE(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FROZEN_ITER_INIT(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_FROZEN_ITER_NEXT(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_COMPARE(namespace, base_t, vect_t) \
+	how _VECTOR_DEFINE_SET_INTERSECTION_FAST(namespace, base_t, vect_t)
+
+/*
+ * Do Declare Bits
+ */
+#define _VECTOR_DO_DECLARE_BITS(how, namespace, vect_t) \
+	_VECTOR_DEFINE_BITS_TYPE(vect_t) \
+	how _VECTOR_DECLARE_BITS_INIT(namespace, vect_t); \
+	how _VECTOR_DECLARE_ALLOC(namespace, uint64_t, vect_t); \
+	how _VECTOR_DECLARE_BITS_DESTROY(namespace, vect_t); \
+	how _VECTOR_DECLARE_FREE(namespace, uint64_t, vect_t); \
+	how _VECTOR_DECLARE_BITS_EXPAND(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_SET_LEN(namespace, vect_t); \
+	how _VECTOR_DECLARE_LEN(namespace, uint64_t, vect_t); \
+	how _VECTOR_DECLARE_CAP(namespace, uint64_t, vect_t); \
+	how _VECTOR_DECLARE_BITS_PUSH(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_POP(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_INDEX(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_SET_INDEX(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_BULK(namespace, vect_t, and); \
+	how _VECTOR_DECLARE_BITS_BULK(namespace, vect_t, or); \
+	how _VECTOR_DECLARE_BITS_BULK(namespace, vect_t, xor); \
+	how _VECTOR_DECLARE_BITS_BULK(namespace, vect_t, andnot); \
+	how _VECTOR_DECLARE_BITS_COUNT(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_FIND_FIRST_SET(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_RANK_BUILD(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_RANK(namespace, vect_t); \
+	how _VECTOR_DECLARE_BITS_SELECT(namespace, vect_t);
+
+/*
+ * Do Define Bits
+ */
+#define _VECTOR_DO_DEFINE_BITS(how, namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_INIT(namespace, vect_t) \
+	how _VECTOR_DEFINE_ALLOC(namespace, uint64_t, vect_t) \
+	how _VECTOR_DEFINE_BITS_DESTROY(namespace, vect_t) \
+	how _VECTOR_DEFINE_FREE(namespace, uint64_t, vect_t) \
+	how _VECTOR_DEFINE_BITS_EXPAND(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_SET_LEN(namespace, vect_t) \
+	how _VECTOR_DEFINE_LEN(namespace, uint64_t, vect_t) \
+	how _VECTOR_DEFINE_CAP(namespace, uint64_t, vect_t) \
+	how _VECTOR_DEFINE_BITS_PUSH(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_POP(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_INDEX(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_SET_INDEX(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_BULK(namespace, vect_t, and, &) \
+	how _VECTOR_DEFINE_BITS_BULK(namespace, vect_t, or, |) \
+	how _VECTOR_DEFINE_BITS_BULK(namespace, vect_t, xor, ^) \
+	how _VECTOR_DEFINE_BITS_BULK(namespace, vect_t, andnot, & ~) \
+	how _VECTOR_DEFINE_BITS_COUNT(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_FIND_FIRST_SET(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_RANK_BUILD(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_RANK(namespace, vect_t) \
+	how _VECTOR_DEFINE_BITS_SELECT(namespace, vect_t)
+
+/* Declare
+ *
+ * Defines the vector struct and declares all of the associated functions.
+ *
+ * The 'how' field is a list of keywords to place in front of the function
+ * declarations such as 'static inline', 'static', or 'extern'. In C99 and C11,
+ * this field can be left blank, but C89 does not allow this behavior and you
+ * will need to place 'extern' in this field.
+ *
+ * The 'namespace' argument allows you to customize the names of the type and
+ * the functions. The defined type will always be 'namespace_t' and the
+ * functions will be of the format 'namespace_method'.
+ *
+ * The 'type' field is the underlying type of the vector.
+ */
+#define VECTOR_DECLARE(how, namespace, type) \
+	_VECTOR_DO_DECLARE(how, namespace, type, namespace ## _t)
+
+/* Define
+ *
+ * Defines the functions declared by VECTOR_DECLARE. The arguments to this macro
+ * are the same as the ones in VECTOR_DECLARE.
+ */
+#define VECTOR_DEFINE(how, namespace, type) \
+	_VECTOR_DO_DEFINE(how, namespace, type, namespace ## _t)
+
+/* Declare and Define
+ *
+ * A shortcut which calls VECTOR_DECLARE and VECTOR_DEFINE.
+ */
+#define VECTOR_DECLARE_AND_DEFINE(how, namespace, type) \
+	VECTOR_DECLARE(how, namespace, type) \
+	VECTOR_DEFINE(how, namespace, type)
+
+/* Declare Integer
+ *
+ * Declares the additional functions available to vectors of integer types.
+ * The arguments are the same as the ones in VECTOR_DECLARE, which must be
+ * used first with the same namespace.
+ */
+#define VECTOR_DECLARE_INTEGER(how, namespace, type) \
+	_VECTOR_DO_DECLARE_INTEGER(how, namespace, type, namespace ## _t)
+
+/* Define Integer
+ *
+ * Defines the functions declared by VECTOR_DECLARE_INTEGER.
+ */
+#define VECTOR_DEFINE_INTEGER(how, namespace, type) \
+	_VECTOR_DO_DEFINE_INTEGER(how, namespace, type, namespace ## _t)
+
+/* Declare Bits
+ *
+ * Defines a bit vector struct storing one bit per element and declares its
+ * functions. The 'how' and 'namespace' arguments are the same as the ones
+ * in VECTOR_DECLARE. Elements are pushed, popped, read and set as ints that
+ * are either 0 or 1.
+ */
+#define VECTOR_DECLARE_BITS(how, namespace) \
+	_VECTOR_DO_DECLARE_BITS(how, namespace, namespace ## _t)
+
+/* Define Bits
+ *
+ * Defines the functions declared by VECTOR_DECLARE_BITS.
+ */
+#define VECTOR_DEFINE_BITS(how, namespace) \
+	_VECTOR_DO_DEFINE_BITS(how, namespace, namespace ## _t)
+
+/*
+ * Initialize a statically allocated vector.
+ */
+#define VECTOR_INITIALIZER { 0, 0, NULL, NULL }
+
+/*
+ * Initialize a statically allocated bit vector.
  */
-#define VECTOR_INITIALIZER { 0, 0, NULL }
+#define VECTOR_BITS_INITIALIZER { 0, 0, NULL, 0, NULL }
 
 #endif /* __VECTOR_H__ */
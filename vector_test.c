@@ -9,6 +9,14 @@
 
 VECTOR_DECLARE(static, vector_int, int)
 VECTOR_DEFINE(static, vector_int, int)
+VECTOR_DECLARE_INTEGER(static, vector_int, int)
+VECTOR_DEFINE_INTEGER(static, vector_int, int)
+VECTOR_DECLARE(static inline, vector_u64, uint64_t)
+VECTOR_DEFINE(static inline, vector_u64, uint64_t)
+VECTOR_DECLARE_INTEGER(static inline, vector_u64, uint64_t)
+VECTOR_DEFINE_INTEGER(static inline, vector_u64, uint64_t)
+VECTOR_DECLARE_BITS(static, vector_bits)
+VECTOR_DEFINE_BITS(static, vector_bits)
 
 static int
 int_compare(int x, int y)
@@ -19,6 +27,25 @@ int_compare(int x, int y)
 	return 0;
 }
 
+/* Compares only the key in the high bits, so equal keys keep their order */
+static int
+key_compare(int x, int y)
+{
+	return int_compare(x >> 16, y >> 16);
+}
+
+static size_t
+int_hash(int x)
+{
+	return (size_t)x;
+}
+
+static int
+int_eq(int x, int y)
+{
+	return x == y;
+}
+
 static int
 test_quicksort(int size, int n_tests)
 {
@@ -61,6 +88,73 @@ test_quicksort(int size, int n_tests)
 	return 0;
 }
 
+static int
+test_stable_sort(int size, int n_tests)
+{
+	vector_int_t v, scratch;
+	int *orig = malloc(size * sizeof(int));
+
+	STDOUT("Running stable sort test...\n");
+
+	if (!orig) {
+		STDERR("malloc: %s\n", strerror(errno));
+		STDOUT("Stable sort failed\n");
+		return -1;
+	}
+
+	vector_int_init(&scratch);
+
+	for (int test_n = 1; test_n <= n_tests; test_n++) {
+		int failed = 0;
+
+		vector_int_init(&v);
+
+		/* Random, sorted, reversed and few unique keys, with the
+		 * original position in the low 16 bits.
+		 */
+		for (int i = 0; i < size; i++) {
+			int key;
+			switch (test_n % 4) {
+			case 0: key = rand() % 32768; break;
+			case 1: key = i * 32768 / size; break;
+			case 2: key = (size - i) * 32767 / size; break;
+			default: key = rand() % 4; break;
+			}
+			orig[i] = key << 16 | (i & 0xffff);
+			if (vector_int_push(&v, orig[i])) {
+				STDERR("vector_int_push: %s\n", strerror(errno));
+				failed = 1;
+				break;
+			}
+		}
+
+		/* Every element must come from its original position, and the
+		 * positions strictly increase within a key, so the result is a
+		 * stably sorted permutation of the input.
+		 */
+		failed = failed || vector_int_stable_sort(&v, &scratch, key_compare) ||
+			v.len != (size_t)size;
+		for (size_t i = 0; !failed && i < v.len; i++)
+			failed = (v.arr[i] & 0xffff) >= size ||
+				orig[v.arr[i] & 0xffff] != v.arr[i] ||
+				(i && v.arr[i - 1] >= v.arr[i]);
+
+		vector_int_destroy(&v);
+
+		if (failed) {
+			STDOUT("Stable sort failed\n");
+			vector_int_destroy(&scratch);
+			free(orig);
+			return -1;
+		}
+	}
+
+	vector_int_destroy(&scratch);
+	free(orig);
+	STDOUT("Stable sort passed\n");
+	return 0;
+}
+
 static int
 test_push_pop(int size, int n_tests)
 {
@@ -242,6 +336,778 @@ test_index(int size, int n_tests)
 	return 0;
 }
 
+static int
+test_compressed(int size, int n_tests)
+{
+	vector_int_t v;
+	vector_int_frozen_t f;
+	vector_int_frozen_iter_t it;
+
+	STDOUT("Running compressed test...\n");
+
+	for (int test_n = 1; test_n <= n_tests; test_n++) {
+
+		vector_int_init(&v);
+
+		/* Alternate sorted runs and random negative values */
+		for (int i = 0, x = 0; i < size; i++) {
+			x += rand() % 100;
+			int err = vector_int_push(&v, (i / 1000) % 2 ? x : -rand());
+			if (err) {
+				STDERR("vector_int_push: %s\n", strerror(errno));
+				STDOUT("Compressed failed\n");
+				vector_int_destroy(&v);
+				return -1;
+			}
+		}
+
+		if (vector_int_freeze_compressed(&v, &f)) {
+			STDERR("vector_int_freeze_compressed: %s\n", strerror(errno));
+			STDOUT("Compressed failed\n");
+			vector_int_destroy(&v);
+			return -1;
+		}
+
+		vector_int_frozen_iter_init(&it, &f);
+		for (int i = 0; i < size; i++) {
+			int x, y;
+			if (vector_int_frozen_index(&f, i, &x) ||
+				vector_int_frozen_iter_next(&it, &y) ||
+				x != v.arr[i] || y != v.arr[i]) {
+				STDOUT("Compressed failed\n");
+				vector_int_frozen_destroy(&f);
+				vector_int_destroy(&v);
+				return -1;
+			}
+		}
+
+		/* The random half needs 32 bits, the sorted half far fewer */
+		if (!vector_int_frozen_iter_next(&it, NULL) ||
+			!vector_int_frozen_index(&f, size, NULL) ||
+			vector_int_frozen_len(&f) != (size_t)size ||
+			vector_int_frozen_size(&f) >= size * sizeof(int)) {
+			STDOUT("Compressed failed\n");
+			vector_int_frozen_destroy(&f);
+			vector_int_destroy(&v);
+			return -1;
+		}
+
+		vector_int_frozen_destroy(&f);
+		vector_int_destroy(&v);
+	}
+
+	/* One element and constant vectors pack to no words at all */
+	for (int n = 1; n <= size; n += size - 1) {
+		int failed = 0, x;
+
+		vector_int_init(&v);
+		for (int i = 0; !failed && i < n; i++)
+			failed = vector_int_push(&v, 42);
+
+		failed = failed || vector_int_freeze_compressed(&v, &f);
+		if (failed) {
+			STDOUT("Compressed failed\n");
+			vector_int_destroy(&v);
+			return -1;
+		}
+
+		vector_int_frozen_iter_init(&it, &f);
+		failed = vector_int_frozen_len(&f) != (size_t)n ||
+			f.n_words != 0;
+		for (int i = 0; !failed && i < n; i++)
+			failed = vector_int_frozen_index(&f, i, &x) || x != 42 ||
+				vector_int_frozen_iter_next(&it, &x) || x != 42;
+
+		vector_int_frozen_destroy(&f);
+		vector_int_destroy(&v);
+
+		if (failed) {
+			STDOUT("Compressed failed\n");
+			return -1;
+		}
+	}
+
+	STDOUT("Compressed passed\n");
+	return 0;
+}
+
+static uint64_t
+rand64(void)
+{
+	return (uint64_t)rand() << 42 ^ (uint64_t)rand() << 21 ^ rand();
+}
+
+static int
+test_compressed_wide(int size, int n_tests)
+{
+	vector_u64_t v;
+	vector_u64_frozen_t f;
+	vector_u64_frozen_iter_t it;
+	uint64_t *out = malloc(128 * sizeof(uint64_t));
+
+	STDOUT("Running compressed wide test...\n");
+
+	if (!out) {
+		STDERR("malloc: %s\n", strerror(errno));
+		STDOUT("Compressed wide failed\n");
+		return -1;
+	}
+
+	for (int test_n = 1; test_n <= n_tests; test_n++) {
+		int failed = 0, wide = 0;
+		uint64_t x = UINT64_C(1) << 63;
+
+		vector_u64_init(&v);
+
+		/* Rotate blocks of full width values, values near the top of the
+		 * range and a sorted run, so some blocks are stored unpacked.
+		 */
+		for (int i = 0; !failed && i < size; i++) {
+			switch ((i / 128) % 3) {
+			case 0: wide++; failed = vector_u64_push(&v, rand64()); break;
+			case 1: failed = vector_u64_push(&v, UINT64_MAX - rand() % 1000); break;
+			case 2: x += rand() % 100; failed = vector_u64_push(&v, x); break;
+			}
+		}
+
+		failed = failed || vector_u64_freeze_compressed(&v, &f);
+		if (failed) {
+			STDERR("vector_u64_freeze_compressed: %s\n", strerror(errno));
+			STDOUT("Compressed wide failed\n");
+			vector_u64_destroy(&v);
+			free(out);
+			return -1;
+		}
+
+		vector_u64_frozen_iter_init(&it, &f);
+		for (int i = 0; !failed && i < size; i++) {
+			uint64_t a, b;
+			failed = vector_u64_frozen_index(&f, i, &a) ||
+				vector_u64_frozen_iter_next(&it, &b) ||
+				a != v.arr[i] || b != v.arr[i];
+		}
+		for (size_t i = 0; !failed && i * 128 < (size_t)size; i++) {
+			size_t n = vector_u64_frozen_decode(&f, i, out);
+			for (size_t j = 0; !failed && j < n; j++)
+				failed = out[j] != v.arr[i * 128 + j];
+		}
+
+		/* Unpacked blocks take their full width, the others much less */
+		failed = failed || vector_u64_frozen_len(&f) != (size_t)size ||
+			vector_u64_frozen_size(&f) < wide * sizeof(uint64_t) ||
+			vector_u64_frozen_size(&f) >= size * sizeof(uint64_t);
+
+		vector_u64_frozen_destroy(&f);
+		vector_u64_destroy(&v);
+
+		if (failed) {
+			STDOUT("Compressed wide failed\n");
+			free(out);
+			return -1;
+		}
+	}
+
+	free(out);
+	STDOUT("Compressed wide passed\n");
+	return 0;
+}
+
+static int
+test_bits(int size, int n_tests)
+{
+	vector_bits_t v, w, u;
+	char *ref = malloc(size), *uref = malloc(size);
+
+	STDOUT("Running bits test...\n");
+
+	if (!ref || !uref) {
+		STDERR("malloc: %s\n", strerror(errno));
+		STDOUT("Bits failed\n");
+		free(ref);
+		free(uref);
+		return -1;
+	}
+
+	for (int test_n = 1; test_n <= n_tests; test_n++) {
+		vector_bits_t *h;
+		size_t count = 0, pos;
+		int x, failed = 0;
+
+		vector_bits_init(&v);
+		vector_bits_init(&w);
+		vector_bits_init(&u);
+
+		for (int i = 0; i < size; i++) {
+			ref[i] = rand() % 3 == 0;
+			uref[i] = rand() % 2;
+			if (vector_bits_push(&v, ref[i]) || vector_bits_push(&w, i % 2) ||
+				vector_bits_push(&u, uref[i])) {
+				STDERR("vector_bits_push: %s\n", strerror(errno));
+				failed = 1;
+				break;
+			}
+		}
+
+		/* Flip every 5th bit, then keep only the even bits */
+		for (int i = 0; !failed && i < size; i += 5) {
+			ref[i] = !ref[i];
+			failed |= vector_bits_set_index(&v, i, ref[i]);
+		}
+		for (int i = 1; i < size; i += 2)
+			ref[i] = 0;
+		failed |= vector_bits_andnot(&v, &w);
+
+		for (int pass = 0; !failed && pass < 2; pass++) {
+			/* The second pass uses the rank directory */
+			if (pass && vector_bits_rank_build(&v)) {
+				failed = 1;
+				break;
+			}
+
+			count = 0;
+			for (int i = 0; i < size; i++) {
+				if (vector_bits_index(&v, i, &x) || x != ref[i] ||
+					vector_bits_rank(&v, i) != count) {
+					failed = 1;
+					break;
+				}
+				if (ref[i]) {
+					if (vector_bits_select(&v, count, &pos) ||
+						pos != (size_t)i ||
+						vector_bits_find_first_set(&v, i, &pos) ||
+						pos != (size_t)i) {
+						failed = 1;
+						break;
+					}
+					count++;
+				}
+			}
+
+			if (vector_bits_count(&v) != count ||
+				!vector_bits_select(&v, count, NULL))
+				failed = 1;
+		}
+
+		/* Xor and or with random bits, then keep only the odd bits */
+		failed = failed || vector_bits_xor(&v, &u);
+		for (int i = 0; !failed && i < size; i++) {
+			ref[i] ^= uref[i];
+			failed = vector_bits_index(&v, i, &x) || x != ref[i];
+		}
+		failed = failed || vector_bits_or(&v, &u);
+		for (int i = 0; !failed && i < size; i++) {
+			ref[i] |= uref[i];
+			failed = vector_bits_index(&v, i, &x) || x != ref[i];
+		}
+		failed = failed || vector_bits_and(&v, &w);
+		for (int i = 0; !failed && i < size; i++) {
+			ref[i] &= i % 2;
+			failed = vector_bits_index(&v, i, &x) || x != ref[i];
+		}
+
+		/* Lengths must match */
+		failed = failed || vector_bits_pop(&u, &x) || !vector_bits_and(&v, &u);
+
+		for (int i = size - 1; !failed && i >= 0; i--)
+			if (vector_bits_pop(&v, &x) || x != ref[i])
+				failed = 1;
+
+		/* Regrown bits must read as 0 */
+		if (!failed && (vector_bits_set_len(&v, size) || vector_bits_count(&v)))
+			failed = 1;
+
+		/* A heap allocated bit vector counts 'len' and 'cap' in bits */
+		h = vector_bits_alloc();
+		count = 0;
+		failed = failed || !h;
+		for (int i = 0; !failed && i < size; i++) {
+			count += ref[i];
+			failed = vector_bits_push(h, ref[i]);
+		}
+		failed = failed || vector_bits_len(h) != (size_t)size ||
+			vector_bits_cap(h) < (size_t)size || vector_bits_cap(h) % 64 ||
+			vector_bits_rank_build(h) || vector_bits_count(h) != count;
+		vector_bits_free(h);
+
+		vector_bits_destroy(&v);
+		vector_bits_destroy(&w);
+		vector_bits_destroy(&u);
+
+		if (failed) {
+			STDOUT("Bits failed\n");
+			free(ref);
+			free(uref);
+			return -1;
+		}
+	}
+
+	free(ref);
+	free(uref);
+	STDOUT("Bits passed\n");
+	return 0;
+}
+
+/* Fill 'v' with a strictly increasing random subset of [0, range) of
+ * roughly 'size' elements, marking members in 'member'.
+ */
+static int
+random_set(vector_int_t *v, int size, int range, char *member)
+{
+	vector_int_init(v);
+	for (int i = 0; i < range; i++) {
+		member[i] = rand() % range < size;
+		if (member[i] && vector_int_push(v, i))
+			return -1;
+	}
+
+	return 0;
+}
+
+static int
+test_set_algebra(int size, int n_tests)
+{
+	int range = size * 4;
+	char *in_a = malloc(range), *in_b = malloc(range);
+	vector_int_t a, b, out, fast;
+
+	STDOUT("Running set algebra test...\n");
+
+	if (!in_a || !in_b) {
+		STDERR("malloc: %s\n", strerror(errno));
+		STDOUT("Set algebra failed\n");
+		free(in_a);
+		free(in_b);
+		return -1;
+	}
+
+	vector_int_init(&out);
+	vector_int_init(&fast);
+
+	for (int test_n = 1; test_n <= n_tests; test_n++) {
+		/* Every other test uses skewed sizes to exercise galloping */
+		int size_b = test_n % 2 ? size : size / 64 + 1;
+		vector_int_t *vs[3];
+		size_t k;
+		int failed = 0;
+
+		if (random_set(&a, size, range, in_a) ||
+			random_set(&b, size_b, range, in_b)) {
+			STDERR("vector_int_push: %s\n", strerror(errno));
+			failed = 1;
+		}
+
+		failed = failed || vector_int_merge(&a, &b, &out, int_compare) ||
+			out.len != a.len + b.len;
+		for (k = 1; !failed && k < out.len; k++)
+			failed = out.arr[k - 1] > out.arr[k];
+
+		vs[0] = &b;
+		vs[1] = &a;
+		vs[2] = &b;
+		failed = failed || vector_int_merge_many(vs, 3, &out, int_compare) ||
+			out.len != a.len + 2 * b.len;
+		for (k = 1; !failed && k < out.len; k++)
+			failed = out.arr[k - 1] > out.arr[k];
+
+		failed = failed || vector_int_set_union(&a, &b, &out, int_compare);
+		for (int i = 0, n = 0; !failed && i <= range; i++) {
+			if (i == range)
+				failed = (size_t)n != out.len;
+			else if (in_a[i] || in_b[i])
+				failed = out.arr[n++] != i;
+		}
+
+		failed = failed ||
+			vector_int_set_intersection(&a, &b, &out, int_compare) ||
+			vector_int_set_intersection_fast(&b, &a, &fast) ||
+			fast.len != out.len;
+		for (int i = 0, n = 0; !failed && i <= range; i++) {
+			if (i == range)
+				failed = (size_t)n != out.len;
+			else if (in_a[i] && in_b[i])
+				failed = out.arr[n] != i || fast.arr[n++] != i;
+		}
+
+		failed = failed ||
+			vector_int_set_difference(&a, &b, &out, int_compare);
+		for (int i = 0, n = 0; !failed && i <= range; i++) {
+			if (i == range)
+				failed = (size_t)n != out.len;
+			else if (in_a[i] && !in_b[i])
+				failed = out.arr[n++] != i;
+		}
+
+		vector_int_destroy(&a);
+		vector_int_destroy(&b);
+
+		if (failed) {
+			STDOUT("Set algebra failed\n");
+			vector_int_destroy(&out);
+			vector_int_destroy(&fast);
+			free(in_a);
+			free(in_b);
+			return -1;
+		}
+	}
+
+	vector_int_destroy(&out);
+	vector_int_destroy(&fast);
+	free(in_a);
+	free(in_b);
+	STDOUT("Set algebra passed\n");
+	return 0;
+}
+
+/* Fills 'v' with 'size' elements of nondecreasing keys with repeats. The
+ * low bits tag each element with 'tag' and its position, so the elements
+ * taken for equal keys can be told apart.
+ */
+static int
+random_multiset(vector_int_t *v, int size, int tag)
+{
+	vector_int_init(v);
+	for (int i = 0, key = 0; i < size; i++) {
+		key += rand() % 4 == 0;
+		if (vector_int_push(v, key << 16 | tag << 14 | (i & 0x3fff)))
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Reference set operation by counting equal keys: for a key with 'm'
+ * elements in 'a' and 'n' in 'b', merge ('m') keeps all of 'a' then all of
+ * 'b', union ('u') keeps all of 'a' then the last n - m of 'b', intersection
+ * ('i') keeps the first min(m, n) of 'a' and difference ('d') keeps the
+ * last m - n of 'a'.
+ */
+static int
+keyed_reference(vector_int_t *a, vector_int_t *b, int op, vector_int_t *out)
+{
+	size_t i = 0, j = 0, ie, je, m, n, k;
+	int key;
+
+	out->len = 0;
+	while (i < a->len || j < b->len) {
+		if (j == b->len || (i < a->len && a->arr[i] >> 16 < b->arr[j] >> 16))
+			key = a->arr[i] >> 16;
+		else
+			key = b->arr[j] >> 16;
+
+		for (ie = i; ie < a->len && a->arr[ie] >> 16 == key; ie++)
+			;
+		for (je = j; je < b->len && b->arr[je] >> 16 == key; je++)
+			;
+		m = ie - i;
+		n = je - j;
+
+		for (k = 0; k < m; k++) {
+			if ((op == 'i' && k >= n) || (op == 'd' && k < n))
+				continue;
+			if (vector_int_push(out, a->arr[i + k]))
+				return -1;
+		}
+		for (k = 0; k < n; k++) {
+			if (op == 'i' || op == 'd' || (op == 'u' && k < m))
+				continue;
+			if (vector_int_push(out, b->arr[j + k]))
+				return -1;
+		}
+
+		i = ie;
+		j = je;
+	}
+
+	return 0;
+}
+
+static int
+same_vector(vector_int_t *a, vector_int_t *b)
+{
+	return a->len == b->len &&
+		!memcmp(a->arr, b->arr, a->len * sizeof(*a->arr));
+}
+
+static int
+test_set_algebra_keyed(int size, int n_tests)
+{
+	vector_int_t a, b, c, out, ref, tmp;
+
+	STDOUT("Running keyed set algebra test...\n");
+
+	vector_int_init(&out);
+	vector_int_init(&ref);
+	vector_int_init(&tmp);
+
+	/* Empty inputs and output have no arrays at all */
+	vector_int_init(&a);
+	if (vector_int_merge(&a, &a, &out, key_compare) ||
+		vector_int_set_union(&a, &a, &out, key_compare) ||
+		vector_int_set_difference(&a, &a, &out, key_compare) || out.len) {
+		STDOUT("Keyed set algebra failed\n");
+		vector_int_destroy(&out);
+		return -1;
+	}
+
+	for (int test_n = 1; test_n <= n_tests; test_n++) {
+		/* Skew the sizes either way to exercise both galloping paths */
+		int size_a = test_n % 3 == 2 ? size / 64 + 1 : size;
+		int size_b = test_n % 3 == 1 ? size / 64 + 1 : size;
+		vector_int_t *vs[3];
+		int failed = 0;
+
+		if (random_multiset(&a, size_a, 0) ||
+			random_multiset(&b, size_b, 1) ||
+			random_multiset(&c, size / 2, 2)) {
+			STDERR("vector_int_push: %s\n", strerror(errno));
+			failed = 1;
+		}
+
+		failed = failed || vector_int_merge(&a, &b, &out, key_compare) ||
+			keyed_reference(&a, &b, 'm', &ref) || !same_vector(&out, &ref);
+
+		/* Equal keys come from the earlier vector first */
+		vs[0] = &b;
+		vs[1] = &c;
+		vs[2] = &a;
+		failed = failed ||
+			vector_int_merge_many(vs, 3, &out, key_compare) ||
+			keyed_reference(&b, &c, 'm', &tmp) ||
+			keyed_reference(&tmp, &a, 'm', &ref) || !same_vector(&out, &ref);
+
+		failed = failed || vector_int_set_union(&a, &b, &out, key_compare) ||
+			keyed_reference(&a, &b, 'u', &ref) || !same_vector(&out, &ref);
+
+		failed = failed ||
+			vector_int_set_intersection(&a, &b, &out, key_compare) ||
+			keyed_reference(&a, &b, 'i', &ref) || !same_vector(&out, &ref);
+
+		failed = failed ||
+			vector_int_set_difference(&a, &b, &out, key_compare) ||
+			keyed_reference(&a, &b, 'd', &ref) || !same_vector(&out, &ref);
+
+		vector_int_destroy(&a);
+		vector_int_destroy(&b);
+		vector_int_destroy(&c);
+
+		if (failed) {
+			STDOUT("Keyed set algebra failed\n");
+			vector_int_destroy(&out);
+			vector_int_destroy(&ref);
+			vector_int_destroy(&tmp);
+			return -1;
+		}
+	}
+
+	vector_int_destroy(&out);
+	vector_int_destroy(&ref);
+	vector_int_destroy(&tmp);
+	STDOUT("Keyed set algebra passed\n");
+	return 0;
+}
+
+static int
+test_gather_scatter(int size, int n_tests)
+{
+	vector_int_t v;
+	vector_u64_t w;
+	size_t *indices = malloc(size * sizeof(size_t));
+	int *values = malloc(size * sizeof(int));
+	uint64_t *wide = malloc(size * sizeof(uint64_t));
+
+	STDOUT("Running gather/scatter test...\n");
+
+	if (!indices || !values || !wide) {
+		STDERR("malloc: %s\n", strerror(errno));
+		STDOUT("Gather/Scatter failed\n");
+		free(indices);
+		free(values);
+		free(wide);
+		return -1;
+	}
+
+	for (int test_n = 1; test_n <= n_tests; test_n++) {
+		int failed = 0;
+
+		vector_int_init(&v);
+		if (vector_int_set_len(&v, size)) {
+			STDERR("vector_int_set_len: %s\n", strerror(errno));
+			failed = 1;
+		}
+
+		/* Scatter a random permutation, then gather it back */
+		for (int i = 0; i < size; i++) {
+			size_t j = rand() % (i + 1);
+			indices[i] = indices[j];
+			indices[j] = i;
+		}
+		for (int i = 0; i < size; i++)
+			values[i] = rand();
+
+		failed = failed || vector_int_scatter(&v, indices, values, size);
+		for (int i = 0; !failed && i < size; i++)
+			failed = v.arr[indices[i]] != values[i];
+
+		memset(values, 0, size * sizeof(int));
+		failed = failed || vector_int_gather(&v, indices, size, values);
+		for (int i = 0; !failed && i < size; i++)
+			failed = values[i] != v.arr[indices[i]];
+
+		/* 64 bit elements take the AVX2 path when it is enabled, with an
+		 * odd count so the last elements are read one at a time.
+		 */
+		vector_u64_init(&w);
+		failed = failed || vector_u64_set_len(&w, size);
+		for (int i = 0; !failed && i < size; i++)
+			w.arr[i] = rand64();
+		failed = failed || vector_u64_gather(&w, indices, size - 1, wide);
+		for (int i = 0; !failed && i < size - 1; i++)
+			failed = wide[i] != w.arr[indices[i]];
+
+		/* One index out of range fails the whole batch */
+		indices[size / 2] = size;
+		failed = failed || !vector_int_gather(&v, indices, size, values) ||
+			!vector_int_scatter(&v, indices, values, size) ||
+			!vector_u64_gather(&w, indices, size, wide);
+		indices[size / 2] = SIZE_MAX;
+		failed = failed || !vector_u64_gather(&w, indices, size, wide);
+
+		vector_int_destroy(&v);
+		vector_u64_destroy(&w);
+
+		if (failed) {
+			STDOUT("Gather/Scatter failed\n");
+			free(indices);
+			free(values);
+			free(wide);
+			return -1;
+		}
+	}
+
+	free(indices);
+	free(values);
+	free(wide);
+	STDOUT("Gather/Scatter passed\n");
+	return 0;
+}
+
+/* Returns a value to store in the hash index test, counting up from 'next'
+ * when the values must be distinct.
+ */
+static int
+index_value(int unique, int *next, int size)
+{
+	return unique ? (*next)++ : rand() % size;
+}
+
+static int
+test_hash_index(int size, int n_tests)
+{
+	vector_int_t v, scratch = VECTOR_INITIALIZER;
+	size_t indices[4];
+	int values[4];
+
+	STDOUT("Running hash index test...\n");
+
+	for (int test_n = 1; test_n <= n_tests; test_n++) {
+		/* Odd tests use distinct values, so each one is found at
+		 * exactly its own position, even tests repeat values.
+		 */
+		int unique = test_n % 2, next = 0, failed = 0, x;
+		size_t out, found = 0;
+
+		vector_int_init(&v);
+		for (int i = 0; i < size / 2; i++)
+			failed = failed ||
+				vector_int_push(&v, index_value(unique, &next, size));
+		failed = failed || vector_int_index_build(&v, int_hash, int_eq);
+
+		/* Every mutator must leave the index in step with the vector */
+		for (int i = 0; !failed && i < size; i++) {
+			size_t j = v.len ? rand() % v.len : 0;
+
+			x = index_value(unique, &next, size);
+			switch (v.len ? rand() % 11 : 0) {
+			case 0: failed = vector_int_push(&v, x); break;
+			case 1: failed = vector_int_pop(&v, &x); break;
+			case 2: failed = vector_int_remove_fast(&v, j, &x); break;
+			case 3: failed = vector_int_set_index(&v, j, x); break;
+			case 4: failed = vector_int_swap(&v, j, rand() % v.len); break;
+			case 5: failed = vector_int_insert_fast(&v, j, x); break;
+			case 6:
+				if (rand() % 16 == 0)
+					failed = vector_int_insert(&v, j, x);
+				break;
+			case 7:
+				if (rand() % 16 == 0)
+					failed = vector_int_remove(&v, j, &x);
+				break;
+			case 8:
+				if (rand() % 256 == 0)
+					vector_int_quicksort(&v, int_compare);
+				break;
+			case 9:
+				for (int k = 0; k < 4; k++) {
+					indices[k] = rand() % v.len;
+					values[k] = index_value(unique, &next, size);
+				}
+				/* Distinct values must go to distinct positions */
+				if (unique)
+					for (int k = 1; k < 4; k++)
+						indices[k] = (indices[k - 1] + 1) % v.len;
+				failed = vector_int_scatter(&v, indices, values,
+					unique && v.len < 4 ? 1 : 4);
+				break;
+			case 10:
+				if (rand() % 64 == 0)
+					failed = vector_int_set_len(&v, j);
+				break;
+			}
+		}
+
+		failed = failed || v.index->used != v.len;
+		for (size_t i = 0; !failed && i < v.len; i++)
+			failed = vector_int_index_find(&v, v.arr[i], &out) ||
+				v.arr[out] != v.arr[i] || (unique && out != i);
+		for (int i = 0; !failed && i < size; i++)
+			failed = !vector_int_index_find(&v, -1 - i, &out);
+
+		/* Values removed from the vector are no longer found */
+		for (int i = 0; !failed && unique && i < next; i++)
+			found += !vector_int_index_find(&v, i, NULL);
+		failed = failed || (unique && found != v.len);
+
+		/* The elements of a scratch vector are overwritten */
+		failed = failed ||
+			vector_int_index_build(&scratch, int_hash, int_eq) ||
+			vector_int_stable_sort(&v, &scratch, int_compare) ||
+			scratch.index;
+		vector_int_index_drop(&scratch);
+
+		/* Writing the array directly leaves the index stale, but the
+		 * mutators must still stay in bounds.
+		 */
+		if (!failed && v.len >= 2) {
+			v.arr[0] = -1 - size;
+			failed = vector_int_swap(&v, 0, 1);
+		}
+
+		vector_int_index_drop(&v);
+		failed = failed || !vector_int_index_find(&v, 0, &out) || v.index;
+		vector_int_destroy(&v);
+
+		if (failed) {
+			STDOUT("Hash index failed\n");
+			vector_int_destroy(&scratch);
+			return -1;
+		}
+	}
+
+	vector_int_destroy(&scratch);
+	STDOUT("Hash index passed\n");
+	return 0;
+}
+
 int
 main(void)
 {
@@ -250,5 +1116,13 @@ main(void)
 	test_insert_remove_fast(10000, 1000);
 	test_index(10000, 1000);
 	test_quicksort(10000, 1000);
+	test_stable_sort(10000, 1000);
+	test_compressed(10000, 100);
+	test_compressed_wide(10000, 100);
+	test_bits(10000, 100);
+	test_set_algebra(10000, 100);
+	test_set_algebra_keyed(10000, 100);
+	test_gather_scatter(10000, 100);
+	test_hash_index(10000, 100);
 	exit(0);
 }